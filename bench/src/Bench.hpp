@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+// Minimal benchmark registry, FE_BENCH functions run in registration order and report through Bench::Measure
+
+namespace FoxEngine::Bench
+{
+	struct Case final
+	{
+		const char* name;
+		void (*function)();
+	};
+
+	std::vector<Case>& Registry();
+
+	struct Registrar final
+	{
+		Registrar(const char* name, void (*function)())
+		{
+			Registry().push_back({ name, function });
+		}
+	};
+
+	inline const void* volatile gSink = nullptr;
+
+	// Makes the optimizer assume the value is observed, so the work producing it is kept
+	template<class T>
+	void DoNotOptimize(const T& value)
+	{
+		gSink = &value;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+
+	void Report(const char* label, double bestMilliseconds, double medianMilliseconds, int repetitions);
+
+	// Makes a gl 3.3 context current on a hidden window, created on first use and kept until exit.
+	// Gpu cases return early when this fails, they must release their gl objects before returning
+	bool GlContext();
+
+	// Times repetitions runs of function and reports the best and the median run
+	template<class Function>
+	void Measure(const char* label, int repetitions, Function&& function)
+	{
+		std::vector<double> milliseconds;
+		milliseconds.reserve(repetitions);
+
+		for (int i = 0; i < repetitions; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			milliseconds.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		std::sort(milliseconds.begin(), milliseconds.end());
+		Report(label, milliseconds.front(), milliseconds[milliseconds.size() / 2], repetitions);
+	}
+}
+
+#define FE_BENCH(name) \
+	static void name(); \
+	static ::FoxEngine::Bench::Registrar name##Registrar{ #name, name }; \
+	static void name()
@@ -0,0 +1,62 @@
+#include "Bench.hpp"
+
+#include "engine/blob.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Touches one byte per page, enough to fault in a mapping without timing a full scan
+	std::size_t TouchPages(const FoxEngine::Blob& blob)
+	{
+		std::size_t sum = 0;
+
+		for (std::size_t i = 0; i < blob.size(); i += 4096)
+			sum += static_cast<std::size_t>(blob.data()[i]);
+
+		return sum;
+	}
+
+	void Compare(std::size_t size)
+	{
+		std::string path = (std::filesystem::temp_directory_path() / "foxengine_blob_bench.bin").string();
+
+		{
+			std::vector<char> data(size);
+
+			for (std::size_t i = 0; i < size; ++i)
+				data[i] = static_cast<char>(i * 31);
+
+			std::ofstream out{ path, std::ios::out | std::ios::binary | std::ios::trunc };
+			out.write(data.data(), data.size());
+		}
+
+		// Both read a warm page cache, the first run of each is part of the measurement
+		std::string label = std::to_string(size >> 20) + " MiB";
+
+		FoxEngine::Bench::Measure(("FromFile " + label).c_str(), 10, [&]
+			{
+				FoxEngine::Blob blob = FoxEngine::Blob::FromFile(path);
+				FoxEngine::Bench::DoNotOptimize(TouchPages(blob));
+			});
+
+		FoxEngine::Bench::Measure(("MapFile " + label).c_str(), 10, [&]
+			{
+				FoxEngine::Blob blob = FoxEngine::Blob::MapFile(path);
+				FoxEngine::Bench::DoNotOptimize(TouchPages(blob));
+			});
+
+		std::error_code ec;
+		std::filesystem::remove(path, ec);
+	}
+}
+
+FE_BENCH(BlobLoad)
+{
+	Compare(std::size_t(16) << 20);
+	Compare(std::size_t(256) << 20);
+}
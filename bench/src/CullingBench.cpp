@@ -0,0 +1,81 @@
+#include "Bench.hpp"
+
+#include "engine/AabbTree.hpp"
+#include "engine/FrustumCulling.hpp"
+#include "engine/log.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using namespace FoxEngine;
+
+	// Unit boxes scattered at constant density, so the share inside the frustum stays about the same at every count
+	std::vector<glm::mat4> Scatter(std::size_t count)
+	{
+		std::mt19937 random{ 1234 };
+		float side = 4.0f * std::cbrt(static_cast<float>(count));
+		std::uniform_real_distribution<float> position{ -side * 0.5f, side * 0.5f };
+
+		std::vector<glm::mat4> worlds(count);
+		for (glm::mat4& world : worlds)
+			world = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+
+		return worlds;
+	}
+}
+
+FE_BENCH(FrustumCulling)
+{
+	Mesh::Bounds bounds{ .min = glm::vec3(-0.5f), .max = glm::vec3(0.5f), .center = glm::vec3(0.0f), .radius = 0.87f };
+
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = Frustum::FromMatrix(projection * view);
+
+	for (std::size_t count : { 1'000, 10'000, 100'000 })
+	{
+		std::vector<glm::mat4> worlds = Scatter(count);
+		std::string label = std::to_string(count / 1000) + "k boxes, ";
+
+		CullingBatch batch;
+		std::vector<std::uint8_t> visible;
+
+		// What the linear mode does every frame, the boxes are gathered again before culling
+		Bench::Measure((label + "linear, gather + cull").c_str(), 20, [&]
+		{
+			batch.Clear();
+
+			for (const glm::mat4& world : worlds)
+				batch.Add(bounds, world);
+
+			Bench::DoNotOptimize(batch.Cull(frustum, visible));
+		});
+
+		Bench::Measure((label + "linear, cull only").c_str(), 20, [&]
+		{
+			Bench::DoNotOptimize(batch.Cull(frustum, visible));
+		});
+
+		AabbTree tree;
+		for (std::size_t i = 0; i < count; ++i)
+			tree.Insert(Aabb::FromBounds(bounds, worlds[i]), static_cast<std::uint32_t>(i));
+
+		std::size_t reported = 0;
+
+		Bench::Measure((label + "tree query").c_str(), 20, [&]
+		{
+			reported = 0;
+			Bench::DoNotOptimize(tree.QueryFrustum(frustum, [&](std::uint32_t) { ++reported; }));
+		});
+
+		Log::Info("    {} of {} visible linearly, {} reported by the tree (fattened boxes), tree height {}",
+			batch.Cull(frustum, visible), count, reported, tree.Height());
+	}
+}
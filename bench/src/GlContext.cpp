@@ -0,0 +1,33 @@
+#include "Bench.hpp"
+
+#include "engine/log.hpp"
+#include "engine/window.hpp"
+
+namespace FoxEngine::Bench
+{
+	bool GlContext()
+	{
+		static Window window;
+
+		static const bool ready = []
+			{
+				window = Window({ .width = 256, .height = 256, .title = "FoxEngine bench", .visible = false });
+
+				if (!window.Handle())
+					return false;
+
+				window.MakeContextCurrent();
+				Window::SwapInterval(0);
+
+				if (!Window::LoadGLFunctions())
+				{
+					Log::Error("Failed to load gl functions, skipping gpu benchmarks");
+					return false;
+				}
+
+				return true;
+			}();
+
+		return ready;
+	}
+}
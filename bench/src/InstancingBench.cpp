@@ -0,0 +1,112 @@
+#include "Bench.hpp"
+
+#include "engine/RenderQueue.hpp"
+#include "engine/log.hpp"
+#include "engine/mesh.hpp"
+#include "engine/shader.hpp"
+#include "engine/ogl/StateCacheOGL.hpp"
+
+#include <glad/gl.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using namespace FoxEngine;
+
+	constexpr std::string_view InstancedShaderSource = R"(
+input(vec3, inPosition, 0);
+
+output(vec4, outColor, 0);
+
+#ifdef FE_VERT
+void main(void)
+{
+	gl_Position = feModel * vec4(inPosition, 1.0);
+}
+#elif defined FE_FRAG
+void main(void)
+{
+	outColor = vec4(1.0);
+}
+#endif
+)";
+
+	// A flat grid of quads, about the triangle count of the props the stress grid spawns
+	std::unique_ptr<Mesh> MakeGrid(int quads)
+	{
+		std::vector<Mesh::Vertex> vertices;
+		std::vector<Mesh::Index> indices;
+
+		for (int y = 0; y <= quads; ++y)
+			for (int x = 0; x <= quads; ++x)
+				vertices.push_back({ { x / float(quads), y / float(quads), 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f } });
+
+		for (int y = 0; y < quads; ++y)
+		{
+			for (int x = 0; x < quads; ++x)
+			{
+				Mesh::Index corner = static_cast<Mesh::Index>(y * (quads + 1) + x);
+				Mesh::Index above = corner + static_cast<Mesh::Index>(quads + 1);
+				indices.insert(indices.end(), { corner, corner + 1, above, corner + 1, above + 1, above });
+			}
+		}
+
+		return Mesh::Create({ .vertices = vertices, .indices = indices, .debugName = "Instancing bench" });
+	}
+
+	void Compare(RenderQueue& queue, Shader& shader, const std::vector<std::unique_ptr<Mesh>>& meshes, int entities)
+	{
+		std::vector<glm::mat4> models(entities);
+		for (int i = 0; i < entities; ++i)
+			models[i] = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3((i % 100) * 0.02f - 1.0f, (i / 100 % 100) * 0.02f - 1.0f, 0.0f)), glm::vec3(0.01f));
+
+		std::string label = std::to_string(entities) + " entities, " + std::to_string(meshes.size()) + " meshes";
+
+		for (bool instancing : { false, true })
+		{
+			queue.SetInstancing(instancing);
+
+			// Submission and sorting are part of the cost, the queue is rebuilt every frame in the engine too
+			Bench::Measure((label + (instancing ? ", instanced" : ", per entity")).c_str(), 10, [&]
+			{
+				queue.Clear();
+
+				for (int i = 0; i < entities; ++i)
+					queue.Submit(RenderQueue::Pass::Opaque, shader, nullptr, *meshes[i % meshes.size()], models[i], static_cast<float>(i % 97));
+
+				queue.Execute();
+				glFinish();
+			});
+
+			Log::Info("    {} draw calls, {} instances", queue.GetStats().draws, queue.GetStats().instances);
+		}
+	}
+}
+
+// The per entity path is what RenderQueue did before instancing, SetInstancing(false) keeps it around
+FE_BENCH(RenderQueueInstancing)
+{
+	if (!Bench::GlContext())
+		return;
+
+	std::unique_ptr<Shader> shader = Shader::Create({ .filename = "(bench)", .source = InstancedShaderSource, .debugName = "Instancing bench" }).MakeUnique();
+
+	std::vector<std::unique_ptr<Mesh>> one;
+	one.push_back(MakeGrid(16));
+
+	std::vector<std::unique_ptr<Mesh>> eight;
+	for (int i = 0; i < 8; ++i)
+		eight.push_back(MakeGrid(16));
+
+	glViewport(0, 0, 256, 256);
+	StateCacheOGL::Get().Enable(GL_CULL_FACE);
+
+	RenderQueue queue;
+	Compare(queue, *shader, one, 1'000);
+	Compare(queue, *shader, one, 10'000);
+	Compare(queue, *shader, eight, 10'000);
+}
@@ -0,0 +1,34 @@
+#include "Bench.hpp"
+
+#include "engine/log.hpp"
+
+#include <string_view>
+
+namespace FoxEngine::Bench
+{
+	std::vector<Case>& Registry()
+	{
+		static std::vector<Case> cases;
+		return cases;
+	}
+
+	void Report(const char* label, double bestMilliseconds, double medianMilliseconds, int repetitions)
+	{
+		Log::Info("  {:<48} best {:>10.3f} ms  median {:>10.3f} ms  ({} runs)", label, bestMilliseconds, medianMilliseconds, repetitions);
+	}
+}
+
+// bench [filter], runs every benchmark whose name contains the filter
+int main(int argc, char* argv[])
+{
+	std::string_view filter = argc > 1 ? argv[1] : "";
+
+	for (const FoxEngine::Bench::Case& benchCase : FoxEngine::Bench::Registry())
+	{
+		if (std::string_view(benchCase.name).find(filter) == std::string_view::npos)
+			continue;
+
+		FoxEngine::Log::Info("{}", benchCase.name);
+		benchCase.function();
+	}
+}
@@ -0,0 +1,66 @@
+#include "Bench.hpp"
+
+#include "engine/ShaderPreprocessor.hpp"
+
+#include <regex>
+#include <string>
+
+namespace
+{
+	// The pragma pass ShaderOGL33 ran before ShaderPreprocessor, kept here as the baseline
+	bool RegexPreprocess(std::string& source)
+	{
+		bool cullsBackFaces = true;
+		std::regex regex("^@pragma\\s+([A-Za-z_]+)\\s");
+		std::smatch match;
+
+		while (std::regex_search(source, match, regex))
+		{
+			if (match[1].str() == "backface_nocull")
+				cullsBackFaces = false;
+
+			source = match.prefix().str() + "// (FoxEngine Preprocess) -> " + match[0].str() + match.suffix().str();
+		}
+
+		return cullsBackFaces;
+	}
+
+	// Roughly the shape of the engine shaders, one pragma up front and plain glsl after it
+	std::string MakeShader(std::size_t lines)
+	{
+		std::string source = "@pragma backface_nocull\n";
+
+		for (std::size_t i = 0; i < lines; ++i)
+		{
+			source += "#ifdef FE_FRAG\n";
+			source += "\tvec3 value" + std::to_string(i) + " = normalize(vNormal) * feLightDirection.xyz; // lit\n";
+			source += "#endif\n";
+		}
+
+		return source;
+	}
+}
+
+FE_BENCH(ShaderPreprocess)
+{
+	using namespace FoxEngine;
+
+	for (std::size_t lines : { 1'000, 10'000, 100'000 })
+	{
+		std::string shader = MakeShader(lines);
+		std::string label = std::to_string(shader.size() >> 10) + " KiB";
+
+		Bench::Measure((label + " regex").c_str(), 5, [&]
+		{
+			std::string source = shader;
+			Bench::DoNotOptimize(RegexPreprocess(source));
+			Bench::DoNotOptimize(source);
+		});
+
+		Bench::Measure((label + " ShaderPreprocessor").c_str(), 5, [&]
+		{
+			ShaderPreprocessor::Result result = ShaderPreprocessor::Process("bench.glsl", shader);
+			Bench::DoNotOptimize(result);
+		});
+	}
+}
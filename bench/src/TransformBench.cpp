@@ -0,0 +1,78 @@
+#include "Bench.hpp"
+
+#include "engine/TransformBatch.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Transform final
+	{
+		glm::vec3 translation;
+		glm::quat orientation;
+		glm::vec3 scale;
+	};
+
+	std::vector<Transform> RandomTransforms(std::size_t count)
+	{
+		std::mt19937 random{ 1234 };
+		std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+
+		std::vector<Transform> transforms(count);
+		for (Transform& transform : transforms)
+		{
+			transform.translation = glm::vec3(unit(random), unit(random), unit(random)) * 100.0f;
+			transform.orientation = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+			transform.scale = glm::vec3(1.0f + unit(random) * 0.5f);
+		}
+
+		return transforms;
+	}
+}
+
+// The local matrix pass of Engine::UpdateTransforms with every transform dirty
+FE_BENCH(TransformCompose)
+{
+	using namespace FoxEngine;
+
+	constexpr std::size_t Count = 1'000'000;
+
+	std::vector<Transform> transforms = RandomTransforms(Count);
+	std::vector<glm::mat4> matrices(Count);
+
+	Bench::Measure("1M transforms, glm one at a time", 10, [&]
+	{
+		for (std::size_t i = 0; i < Count; ++i)
+		{
+			const Transform& transform = transforms[i];
+			glm::mat4 matrix = glm::translate(glm::mat4(1.0f), transform.translation);
+			matrix *= glm::toMat4(transform.orientation);
+			matrices[i] = glm::scale(matrix, transform.scale);
+		}
+
+		Bench::DoNotOptimize(matrices.back());
+	});
+
+	TransformBatch batch;
+
+	Bench::Measure("1M transforms, batch gather + compose", 10, [&]
+	{
+		batch.Clear();
+
+		for (const Transform& transform : transforms)
+			batch.Add(transform.translation, transform.orientation, transform.scale);
+
+		batch.Compose(matrices.data());
+		Bench::DoNotOptimize(matrices.back());
+	});
+
+	Bench::Measure("1M transforms, batch compose only", 10, [&]
+	{
+		batch.Compose(matrices.data());
+		Bench::DoNotOptimize(matrices.back());
+	});
+}
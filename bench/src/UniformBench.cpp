@@ -0,0 +1,108 @@
+#include "Bench.hpp"
+
+#include "engine/mesh.hpp"
+#include "engine/shader.hpp"
+
+#include <glad/gl.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+	using namespace FoxEngine;
+
+	// The per draw uniforms the scene pass used to set by name
+	constexpr std::string_view UniformShaderSource = R"(
+input(vec3, inPosition, 0);
+
+output(vec4, outColor, 0);
+
+uniform mat4 uProjection;
+uniform mat4 uView;
+uniform mat4 uModel;
+
+#ifdef FE_VERT
+void main(void)
+{
+	gl_Position = uProjection * uView * uModel * vec4(inPosition, 1.0);
+}
+#elif defined FE_FRAG
+void main(void)
+{
+	outColor = vec4(1.0);
+}
+#endif
+)";
+
+	constexpr int Submissions = 100'000;
+}
+
+FE_BENCH(UniformHandles)
+{
+	if (!Bench::GlContext())
+		return;
+
+	std::unique_ptr<Shader> shader = Shader::Create({ .filename = "(bench)", .source = UniformShaderSource, .debugName = "Uniform bench" }).MakeUnique();
+
+	const Mesh::Vertex vertices[3] = { { { 0.0f, 0.0f, 0.0f } }, { { 1.0f, 0.0f, 0.0f } }, { { 0.0f, 1.0f, 0.0f } } };
+	const Mesh::Index indices[3] = { 0, 1, 2 };
+	std::unique_ptr<Mesh> mesh = Mesh::Create({ .vertices = vertices, .indices = indices, .debugName = "Uniform bench" });
+
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	// The state cache skips values a program already holds, alternating cameras makes every by name call upload
+	const glm::mat4 cameras[2][2] = {
+		{ projection, view },
+		{ glm::perspective(glm::radians(61.0f), 1.0f, 0.1f, 100.0f), glm::lookAt(glm::vec3(0.0f, 0.0f, 5.1f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)) },
+	};
+
+	std::vector<glm::mat4> models(Submissions);
+	for (int i = 0; i < Submissions; ++i)
+		models[i] = glm::translate(glm::mat4(1.0f), glm::vec3((i % 100) * 0.01f, (i / 100 % 100) * 0.01f, 0.0f));
+
+	glViewport(0, 0, 256, 256);
+	glFinish();
+
+	// Every submission sets all three by name, each call hashes the name, binds the shader again and uploads
+	Bench::Measure("100k submissions, by name", 10, [&]
+	{
+		for (int i = 0; i < Submissions; ++i)
+		{
+			const glm::mat4 (&camera)[2] = cameras[i & 1];
+
+			shader->UniformMat4f("uProjection", &camera[0][0][0]);
+			shader->UniformMat4f("uView", &camera[1][0][0]);
+			shader->UniformMat4f("uModel", &models[i][0][0]);
+
+			mesh->Bind();
+			mesh->DrawBound();
+		}
+
+		glFinish();
+	});
+
+	// Resolved once, the camera only when the shader changes, which for one shader is once per frame
+	Bench::Measure("100k submissions, typed handles", 10, [&]
+	{
+		Shader::Uniform<glm::mat4> uProjection = shader->Find<glm::mat4>("uProjection");
+		Shader::Uniform<glm::mat4> uView = shader->Find<glm::mat4>("uView");
+		Shader::Uniform<glm::mat4> uModel = shader->Find<glm::mat4>("uModel");
+
+		shader->Bind();
+		shader->Set(uProjection, projection);
+		shader->Set(uView, view);
+
+		for (const glm::mat4& model : models)
+		{
+			shader->Set(uModel, model);
+
+			mesh->Bind();
+			mesh->DrawBound();
+		}
+
+		glFinish();
+	});
+}
@@ -0,0 +1,51 @@
+input(vec3, inPosition, 0);
+output(vec4, outMask, 0);
+output(vec4, outDepth, 1);
+
+uniform sampler2D uMask;
+uniform sampler2D uDepth;
+
+uniform vec2 uResolution; // Full resolution area in use
+uniform float uScale; // Full resolution pixels per side of a low resolution pixel
+uniform vec2 uClipPlanes; // Near, far
+
+#ifdef FE_VERT
+
+void main(void)
+{
+	gl_Position = vec4(inPosition.xy, 0.0, 1.0);
+}
+
+#elif defined FE_FRAG
+
+float linearDepth(float depth)
+{
+	return uClipPlanes.x * uClipPlanes.y / (uClipPlanes.y - depth * (uClipPlanes.y - uClipPlanes.x));
+}
+
+void main(void)
+{
+	int scale = int(uScale);
+	ivec2 base = ivec2(gl_FragCoord.xy) * scale;
+	ivec2 last = ivec2(uResolution) - 1;
+
+	vec3 mask = vec3(0.0);
+	float nearest = uClipPlanes.y;
+
+	// Box filter the mask, keep the nearest depth so silhouettes stay with the occluder
+	for (int y = 0; y < scale; ++y)
+	{
+		for (int x = 0; x < scale; ++x)
+		{
+			ivec2 texel = min(base + ivec2(x, y), last);
+
+			mask += texelFetch(uMask, texel, 0).rgb;
+			nearest = min(nearest, linearDepth(texelFetch(uDepth, texel, 0).r));
+		}
+	}
+
+	outMask = vec4(mask / float(scale * scale), 1.0);
+	outDepth = vec4(nearest, 0.0, 0.0, 1.0);
+}
+
+#endif
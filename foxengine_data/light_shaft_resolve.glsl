@@ -0,0 +1,72 @@
+input(vec3, inPosition, 0);
+output(vec4, outColor, 0);
+
+uniform sampler2D uCurrent; // This frame's blur
+uniform sampler2D uHistory; // Last frame's output of this shader
+uniform sampler2D uShaftDepth; // Linear, written by light_shaft_downsample.glsl
+
+uniform mat4 uReprojection; // Previous view projection times the inverse of the current one
+uniform vec2 uResolution; // Area in use, shared by every input
+uniform vec2 uHistoryUvScale;
+uniform vec2 uClipPlanes; // Near, far
+uniform float uBlend; // Weight of the current frame
+uniform float uReset;
+
+#ifdef FE_VERT
+
+void main(void)
+{
+	gl_Position = vec4(inPosition.xy, 0.0, 1.0);
+}
+
+#elif defined FE_FRAG
+
+void main(void)
+{
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	ivec2 last = ivec2(uResolution) - 1;
+
+	vec3 current = texelFetch(uCurrent, texel, 0).rgb;
+
+	if (uReset > 0.5)
+	{
+		outColor = vec4(current, 1.0);
+		return;
+	}
+
+	// History outside the range of the neighbourhood is stale, clamping it hides disocclusion and sun movement
+	vec3 low = current;
+	vec3 high = current;
+
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			vec3 neighbour = texelFetch(uCurrent, clamp(texel + ivec2(x, y), ivec2(0), last), 0).rgb;
+			low = min(low, neighbour);
+			high = max(high, neighbour);
+		}
+	}
+
+	// Back to window depth, then to clip space of the previous frame
+	float linear = texelFetch(uShaftDepth, texel, 0).r;
+	float depth = uClipPlanes.y * (linear - uClipPlanes.x) / (linear * (uClipPlanes.y - uClipPlanes.x));
+
+	vec2 uv = gl_FragCoord.xy / uResolution;
+	vec4 previous = uReprojection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+	vec2 previousUv = previous.xy / previous.w * 0.5 + 0.5;
+
+	if (any(lessThan(previousUv, vec2(0.0))) || any(greaterThan(previousUv, vec2(1.0))))
+	{
+		outColor = vec4(current, 1.0);
+		return;
+	}
+
+	// Keep the lookup inside the area last frame rendered to
+	previousUv = clamp(previousUv, 0.5 / uResolution, 1.0 - 0.5 / uResolution);
+	vec3 history = clamp(texture(uHistory, previousUv * uHistoryUvScale).rgb, low, high);
+
+	outColor = vec4(mix(history, current, uBlend), 1.0);
+}
+
+#endif
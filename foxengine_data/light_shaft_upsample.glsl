@@ -0,0 +1,55 @@
+input(vec3, inPosition, 0);
+output(vec4, outColor, 0);
+
+uniform sampler2D uShafts;
+uniform sampler2D uShaftDepth; // Linear, written by light_shaft_downsample.glsl
+uniform sampler2D uDepth;
+
+uniform vec2 uLowResolution; // Low resolution area in use
+uniform float uScale;
+uniform vec2 uClipPlanes; // Near, far
+
+#ifdef FE_VERT
+
+void main(void)
+{
+	gl_Position = vec4(inPosition.xy, 0.0, 1.0);
+}
+
+#elif defined FE_FRAG
+
+float linearDepth(float depth)
+{
+	return uClipPlanes.x * uClipPlanes.y / (uClipPlanes.y - depth * (uClipPlanes.y - uClipPlanes.x));
+}
+
+void main(void)
+{
+	float depth = linearDepth(texelFetch(uDepth, ivec2(gl_FragCoord.xy), 0).r);
+
+	vec2 position = gl_FragCoord.xy / uScale - 0.5;
+	ivec2 base = ivec2(floor(position));
+	vec2 fraction = position - vec2(base);
+	ivec2 last = ivec2(uLowResolution) - 1;
+
+	vec3 color = vec3(0.0);
+	float total = 0.0;
+
+	// Bilinear weights, scaled down where the low resolution depth doesn't match this pixel
+	for (int i = 0; i < 4; ++i)
+	{
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 texel = clamp(base + offset, ivec2(0), last);
+
+		vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+		float difference = abs(texelFetch(uShaftDepth, texel, 0).r - depth) / depth; // Relative, far depth steps are larger
+		float weight = bilinear.x * bilinear.y / (difference + 0.001);
+
+		color += texelFetch(uShafts, texel, 0).rgb * weight;
+		total += weight;
+	}
+
+	outColor = vec4(color / max(total, 0.000001), 1.0);
+}
+
+#endif
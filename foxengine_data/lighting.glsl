@@ -0,0 +1,11 @@
+// Shared lighting for the lit surface shaders
+
+const vec3 feLightDir = vec3(0.0, 0.0, -1.0);
+
+vec3 feApplyLighting(vec3 albedo, vec3 normal, vec3 toCamera)
+{
+	float diffuse = dot(normal, -feLightDir);
+	float specular = dot(reflect(feLightDir, normal), normalize(toCamera));
+
+	return albedo * max(diffuse, 0.1) + pow(max(specular, 0.0), 10.0);
+}
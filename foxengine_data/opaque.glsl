@@ -1,3 +1,6 @@
+// Keywords:
+// CUTOUT    Alpha tested, back faces are lit with a flipped normal. Pair with backface_nocull, see cutout.glsl
+
 input(vec3, inPosition, 0);
 input(vec3, inNormal, 1);
 input(vec2, inTexCoord, 2);
@@ -9,36 +12,37 @@ varying(vec2, vTexCoord);
 varying(vec3, vNormal);
 varying(vec3, vToCamera);
 
-uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
 uniform sampler2D uSampler;
 
 #ifdef FE_VERT
 
 void main(void)
 {
-	vec4 worldSpace = uModel * vec4(inPosition, 1.0);
-	gl_Position = uProjection * uView * worldSpace;
-	vNormal = transpose(inverse(mat3(uModel))) * inNormal;
+	vec4 worldSpace = feModel * vec4(inPosition, 1.0);
+	gl_Position = feViewProjection * worldSpace;
+	vNormal = feNormalMatrix * inNormal;
 	vTexCoord = inTexCoord;
-	vToCamera = (inverse(uView) * vec4(0.0, 0.0, 0.0, 1.0)).xyz - worldSpace.xyz;
+	vToCamera = feCameraPosition.xyz - worldSpace.xyz;
 }
 
 #elif defined FE_FRAG
 
+@include "lighting.glsl"
+
 void main(void)
 {
 	outColor = texture(uSampler, vTexCoord);
+#ifdef CUTOUT
+	if (outColor.a < 0.5) discard;
+#endif
 	outColor.a = 1.0;
 
-	const vec3 lightDir = vec3(0.0, 0.0, -1.0);
-
-	float diffuse = dot(normalize(vNormal), -lightDir);
-	float specular = dot(reflect(lightDir, normalize(vNormal)), normalize(vToCamera));
+	vec3 surfaceNormal = normalize(vNormal);
+#ifdef CUTOUT
+	if(!gl_FrontFacing) surfaceNormal *= -1.0;
+#endif
 
-	outColor.rgb *= max(diffuse, 0.1);
-	outColor.rgb += pow(max(specular, 0.0), 10.0);
+	outColor.rgb = feApplyLighting(outColor.rgb, surfaceNormal, vToCamera);
 
 	outBlack = vec4(0.0, 0.0, 0.0, 1.0);
 }
@@ -6,6 +6,7 @@ varying(vec3, vNormal);
 
 uniform vec2 uCenter;
 uniform vec2 uResolution;
+uniform vec2 uUvScale; // Used fraction of uChannel0
 uniform float uStrength;
 uniform sampler2D uChannel0;
 
@@ -34,7 +35,9 @@ float hash12(vec2 p)
 
 vec4 getSample(vec2 coord)
 {
-    return texture(uChannel0, coord);
+    // Texels past the rendered area hold stale data, clamp like the edge of a full size texture would
+    coord = clamp(coord, 0.5 / uResolution, 1.0 - 0.5 / uResolution);
+    return texture(uChannel0, coord * uUvScale);
 }
 
 void main(void)
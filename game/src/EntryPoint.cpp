@@ -4,17 +4,27 @@
 #include "engine/mesh.hpp"
 #include "engine/log.hpp"
 #include "engine/Poly.hpp"
-#include "engine/Renderbuffer.hpp"
+#include "engine/RenderGraph.hpp"
+#include "engine/AsyncReadback.hpp"
+#include "engine/GpuTimer.hpp"
+#include "engine/GpuProfiler.hpp"
+#include "engine/CpuProfiler.hpp"
+#include "engine/Buffer.hpp"
+#include "engine/RenderQueue.hpp"
+#include "engine/FrustumCulling.hpp"
+#include "engine/AabbTree.hpp"
+#include "engine/OcclusionCulling.hpp"
+#include "engine/TransformBatch.hpp"
+#include "engine/MeshLoader.hpp"
+#include "engine/ResourceManager.hpp"
+#include "engine/ogl/ProgramCacheOGL.hpp"
+#include "engine/ogl/StateCacheOGL.hpp"
 
 #include "vendor/stb_image.h"
 
 #include <GLFW/glfw3.h>
 #include <glad/gl.h>
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-
 #include <entt/entt.hpp>
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -25,11 +35,16 @@
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
 #include <string>
 #include <span>
 #include <vector>
 #include <string_view>
 #include <stdexcept>
+#include <unordered_map>
 
 //#define IMGUI_DISABLE_OBSOLETE_KEYIO
 //#define IMGUI_DISABLE_OBSOLETE_FUNCTIONS
@@ -43,91 +58,29 @@
 
 // Guidelines for the order of includes should be made
 
-// Error prone, needs more logging ability
-static std::unique_ptr<FoxEngine::Mesh> load_mesh(std::string_view resource)
-{
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(resource.data(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_ImproveCacheLocality | aiProcess_OptimizeMeshes);
-
-	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-	{
-		//fe_log_warn("failed to load model: {} with error: {}", resource, importer.GetErrorString());
-		return nullptr;
-	}
-
-	if (scene->mNumMeshes == 0)
-	{
-		//fe_log_warn("scene has no meshes");
-		return nullptr;
-	}
-
-	//if (scene->mNumMeshes != 1)
-		//fe_log_warn("scene has more than one mesh, only the first will be processed");
-
-	//if (scene->mRootNode->mNumChildren != 0)
-		//fe_log_warn("root has children, they will not be processed");
-
-	aiMesh* mesh = scene->mMeshes[0];
-
-	std::vector<FoxEngine::Mesh::Vertex> vertices;
-	vertices.reserve(mesh->mNumVertices);
-
-	std::vector<FoxEngine::Mesh::Index> indices;
-	indices.reserve(mesh->mNumFaces * 3);
-
-	for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
-	{
-		// A lot of this can likely be copied via memcpy
-		FoxEngine::Mesh::Vertex vertex;
-		vertex.position.x = mesh->mVertices[i].x;
-		vertex.position.y = mesh->mVertices[i].y;
-		vertex.position.z = mesh->mVertices[i].z;
-		vertex.normal.x = mesh->mNormals[i].x;
-		vertex.normal.y = mesh->mNormals[i].y;
-		vertex.normal.z = mesh->mNormals[i].z;
-		// Add tangents when needed
-		vertex.texCoord.x = mesh->mTextureCoords[0][i].x;
-		vertex.texCoord.y = mesh->mTextureCoords[0][i].y;
-		vertices.push_back(std::move(vertex));
-	}
-
-	for (unsigned int i = 0; i < mesh->mNumFaces; ++i)
-	{
-		aiFace face = mesh->mFaces[i];
-
-		// We should support lines and points eventually...
-		if (face.mNumIndices != 3) continue;
-
-		for (unsigned int j = 0; j < face.mNumIndices; ++j)
-			indices.push_back(face.mIndices[j]);
-	}
-
-	return FoxEngine::Mesh::Create(
-		{
-			.vertices = vertices,
-			.indices = indices,
-			.debugName = resource
-		});
-}
-
 struct Transform final
 {
 	glm::vec3 translation{};
 	glm::quat orientation = glm::identity<glm::quat>();
 	glm::vec3 scale = glm::vec3(1.0f);
 
+	// Editing the orientation leaves it off unit length, both matrices use the normalized value like UpdateTransforms
 	glm::mat4 ToMatrix() const
 	{
 		glm::mat4 matrix = glm::identity<glm::mat4>();
 		matrix = glm::translate(matrix, translation);
-		matrix *= glm::toMat4(orientation);
+		matrix *= glm::toMat4(glm::normalize(orientation));
 		matrix = glm::scale(matrix, scale);
 		return matrix;
 	}
 
+	// Undoes translation, rotation and scale in reverse order, cheaper than a general inverse
 	glm::mat4 ToInverseMatrix() const
 	{
-		return glm::inverse(ToMatrix());
+		glm::mat4 matrix = glm::scale(glm::identity<glm::mat4>(), 1.0f / scale);
+		matrix *= glm::toMat4(glm::conjugate(glm::normalize(orientation)));
+		matrix = glm::translate(matrix, -translation);
+		return matrix;
 	}
 
 	void FromMatrix(const glm::mat4& matrix)
@@ -138,73 +91,61 @@ struct Transform final
 	}
 };
 
-struct TransformComponent final
+// Only touched by the editor, kept apart so the transform loops stay compact
+struct NameComponent final
 {
-	Transform transform;
 	std::string name = "unnamed";
 	std::string tag = "default";
 };
 
+// Drawn only into the editor icon, the scene pass and picking exclude it
+struct IconTag final {};
+
+struct TransformComponent final
+{
+	Transform transform; // Relative to the parent, edits must be followed by registry.patch
+
+	// Set through Engine::SetParent, the cached matrices are maintained by Engine::UpdateTransforms
+	entt::entity parent = entt::null;
+	glm::mat4 local = glm::identity<glm::mat4>();
+	glm::mat4 world = glm::identity<glm::mat4>();
+	int depth = 0; // Number of ancestors, the storage is sorted by it
+	bool dirty = true; // Local matrix is out of date
+	bool worldChanged = false; // World matrix was recomputed by the last update
+};
+
 struct MeshFilterComponent final
 {
 	std::shared_ptr<FoxEngine::Mesh> mesh;
 	std::string resource;
+
+	FoxEngine::ResourceFuture<FoxEngine::Mesh> pendingMesh;
 };
 
 struct MeshRendererComponent final
 {
 	std::shared_ptr<FoxEngine::Shader> shader;
 	std::string shaderResource;
+	std::string shaderKeywords; // Space separated, selects the shader variant
+	bool occluder = false; // Rasterized into the occlusion buffer, should be large and closed
 
 	std::shared_ptr<FoxEngine::Texture> texture;
 	std::string resource;
-};
 
-#include "engine/UnorderedMapString.hpp"
+	FoxEngine::ResourceFuture<FoxEngine::Shader> pendingShader;
+	FoxEngine::ResourceFuture<FoxEngine::Texture> pendingTexture;
+};
 
-// Not in final use yet
-class ResourceManager final
+// Moves finished async loads into place, the old resource stays in use until then. Returns true if target changed
+template<class T>
+static bool resolve_pending(FoxEngine::ResourceFuture<T>& pending, std::shared_ptr<T>& target)
 {
-public:
-	std::shared_ptr<FoxEngine::Mesh> GetMesh(std::string_view resource)
-	{
-		auto it = mMeshes.find(resource);
-
-		if (it != mMeshes.end())
-			if (std::shared_ptr<FoxEngine::Mesh> ref = it->second.lock())
-				return ref;
-
-		FoxEngine::Log::Info("Loading mesh: {}", resource);
-
-		std::shared_ptr<FoxEngine::Mesh> ref = load_mesh(resource);
-		mMeshes[std::string(resource)] = ref;
-		return ref;
-	}
-
-	std::shared_ptr<FoxEngine::Shader> GetShader(std::string_view resource)
-	{
-		auto it = mShaders.find(resource);
+	if (!FoxEngine::IsReady(pending)) return false;
 
-		if (it != mShaders.end())
-			if (std::shared_ptr<FoxEngine::Shader> ref = it->second.lock())
-				return ref;
-
-		FoxEngine::Log::Info("Loading shader: {}", resource);
-
-		std::shared_ptr<FoxEngine::Shader> ref = FoxEngine::Shader::Create(
-			{
-				.filename = resource,
-				.debugName = resource
-			}).MakeUnique();
-
-		mShaders[std::string(resource)] = ref;
-		return ref;
-	}
-
-private:
-	FoxEngine::UnorderedStringMap<std::weak_ptr<FoxEngine::Mesh>> mMeshes;
-	FoxEngine::UnorderedStringMap<std::weak_ptr<FoxEngine::Shader>> mShaders;
-};
+	target = pending.get();
+	pending = {};
+	return true;
+}
 
 namespace FoxEngine
 {
@@ -260,6 +201,13 @@ namespace FoxEngine
 
 			mDispatcher.sink<WindowCloseEvent>().connect<&Engine::OnClose>(this);
 
+			// Bounds only change through these and UpdateTransforms, edits to transforms or meshes must go through patch
+			mRegistry.on_update<TransformComponent>().connect<&Engine::OnTransformChanged>(this);
+			mRegistry.on_destroy<TransformComponent>().connect<&Engine::OnTransformDestroyed>(this);
+			mRegistry.on_construct<MeshFilterComponent>().connect<&Engine::OnBoundsChanged>(this);
+			mRegistry.on_update<MeshFilterComponent>().connect<&Engine::OnBoundsChanged>(this);
+			mRegistry.on_destroy<MeshFilterComponent>().connect<&Engine::OnBoundsDestroyed>(this);
+
 			std::shared_ptr<FoxEngine::Texture> defaultTex = FoxEngine::Texture::Create(
 				{
 					.width = 1,
@@ -304,25 +252,150 @@ namespace FoxEngine
 					.debugName = "sun.glsl"
 				}).MakeUnique();
 
+			auto uBlurResolution = radialBlurShader->Find<glm::vec2>("uResolution");
+			auto uBlurUvScale = radialBlurShader->Find<glm::vec2>("uUvScale");
+			auto uBlurCenter = radialBlurShader->Find<glm::vec2>("uCenter");
+			auto uBlurStrength = radialBlurShader->Find<float>("uStrength");
+			auto uBlurTime = radialBlurShader->Find<float>("uTime");
+			auto uBlurIterations = radialBlurShader->Find<float>("uIterations");
+
+			auto uSunProjection = sunShader->Find<glm::mat4>("uProjection");
+			auto uSunView = sunShader->Find<glm::mat4>("uView");
+			auto uSunModel = sunShader->Find<glm::mat4>("uModel");
+
+			std::unique_ptr<FoxEngine::Shader> shaftDownsampleShader = FoxEngine::Shader::Create(
+				{
+					.filename = "light_shaft_downsample.glsl",
+					.debugName = "light_shaft_downsample.glsl"
+				}).MakeUnique();
+
+			std::unique_ptr<FoxEngine::Shader> shaftUpsampleShader = FoxEngine::Shader::Create(
+				{
+					.filename = "light_shaft_upsample.glsl",
+					.debugName = "light_shaft_upsample.glsl"
+				}).MakeUnique();
+
+			auto uDownsampleMask = shaftDownsampleShader->Find<int>("uMask");
+			auto uDownsampleDepth = shaftDownsampleShader->Find<int>("uDepth");
+			auto uDownsampleResolution = shaftDownsampleShader->Find<glm::vec2>("uResolution");
+			auto uDownsampleScale = shaftDownsampleShader->Find<float>("uScale");
+			auto uDownsampleClipPlanes = shaftDownsampleShader->Find<glm::vec2>("uClipPlanes");
+
+			std::unique_ptr<FoxEngine::Shader> shaftResolveShader = FoxEngine::Shader::Create(
+				{
+					.filename = "light_shaft_resolve.glsl",
+					.debugName = "light_shaft_resolve.glsl"
+				}).MakeUnique();
+
+			auto uUpsampleShafts = shaftUpsampleShader->Find<int>("uShafts");
+			auto uUpsampleShaftDepth = shaftUpsampleShader->Find<int>("uShaftDepth");
+			auto uUpsampleDepth = shaftUpsampleShader->Find<int>("uDepth");
+			auto uUpsampleLowResolution = shaftUpsampleShader->Find<glm::vec2>("uLowResolution");
+			auto uUpsampleScale = shaftUpsampleShader->Find<float>("uScale");
+			auto uUpsampleClipPlanes = shaftUpsampleShader->Find<glm::vec2>("uClipPlanes");
+
+			auto uResolveCurrent = shaftResolveShader->Find<int>("uCurrent");
+			auto uResolveHistory = shaftResolveShader->Find<int>("uHistory");
+			auto uResolveShaftDepth = shaftResolveShader->Find<int>("uShaftDepth");
+			auto uResolveReprojection = shaftResolveShader->Find<glm::mat4>("uReprojection");
+			auto uResolveResolution = shaftResolveShader->Find<glm::vec2>("uResolution");
+			auto uResolveHistoryUvScale = shaftResolveShader->Find<glm::vec2>("uHistoryUvScale");
+			auto uResolveClipPlanes = shaftResolveShader->Find<glm::vec2>("uClipPlanes");
+			auto uResolveBlend = shaftResolveShader->Find<float>("uBlend");
+			auto uResolveReset = shaftResolveShader->Find<float>("uReset");
+
+			constexpr float nearPlane = 0.1f;
+			constexpr float farPlane = 1000.0f;
+
 			Transform cameraTransform;
 
-			ResourceManager resourceManager;
+			std::unique_ptr<FoxEngine::Buffer> cameraBuffer = FoxEngine::Buffer::Create(
+				{
+					.type = FoxEngine::Buffer::Type::Uniform,
+					.usage = FoxEngine::Buffer::Usage::Stream,
+					.size = sizeof(FoxEngine::Shader::CameraBlock),
+					.debugName = "Camera blocks"
+				});
+
+			FoxEngine::RenderQueue sceneQueue;
+			FoxEngine::RenderQueue iconQueue;
+			sceneQueue.SetDefaultTexture(defaultTex.get());
+			iconQueue.SetDefaultTexture(defaultTex.get());
+			double sceneExecuteMilliseconds = 0.0; // Cpu side only, compare with and without instancing
+
+			// Scene draws are gathered first so the whole frame can be culled in batches
+			struct SceneCandidate final
+			{
+				FoxEngine::Shader* shader;
+				FoxEngine::Texture* texture;
+				FoxEngine::Mesh* mesh;
+				glm::mat4 model;
+				bool occluder;
+			};
+
+			std::vector<SceneCandidate> sceneCandidates;
+			FoxEngine::CullingBatch cullingBatch;
+			std::vector<std::uint8_t> cullingVisible;
+
+			enum struct CullingMode : int
+			{
+				None,
+				Linear, // Every candidate through CullingBatch
+				Tree // Only what the scene tree returns for the frustum
+			};
+
+			CullingMode cullingMode = CullingMode::Tree;
+			std::size_t visibleCount = 0;
+			std::size_t culledCount = 0;
+
+			// Runs after frustum culling on whatever survived it
+			FoxEngine::OcclusionBuffer occlusionBuffer;
+			bool occlusionCulling = true;
+			double occlusionMilliseconds = 0.0;
+
+			// The radial blur takes its taps per output pixel, every step down in resolution makes it 4x cheaper
+			enum struct LightShaftQuality : int
+			{
+				Full,
+				Half,
+				Quarter
+			};
+
+			LightShaftQuality lightShaftQuality = LightShaftQuality::Half;
+			std::array<FoxEngine::GpuTimer, 3> lightShaftTimers; // Per quality, kept to compare against
+
+			// The blur jitters its taps every frame, blending with the reprojected result of earlier frames
+			// turns that noise into the quality of a higher tap count
+			bool temporalShafts = true;
+			float temporalBlend = 0.15f;
+			bool resetShaftHistory = true;
+			int shaftHistoryIndex = 0;
+			int shaftHistoryWidth = 0, shaftHistoryHeight = 0;
+			glm::mat4 previousViewProjection = glm::identity<glm::mat4>();
+			glm::vec3 previousCameraPosition{};
+			glm::vec3 previousCameraForward{};
+			int stressGridSize = 32;
+
+			FoxEngine::ResourceManager resourceManager;
+			std::shared_ptr<FoxEngine::Shader> fallbackShader = resourceManager.FallbackShader();
 
 			{
 				entt::handle entity = { mRegistry, mRegistry.create() };
 				TransformComponent& transform = entity.emplace<TransformComponent>();
+				NameComponent& names = entity.emplace<NameComponent>();
 				MeshFilterComponent& meshFilter = entity.emplace<MeshFilterComponent>();
 				MeshRendererComponent& meshRenderer = entity.emplace<MeshRendererComponent>();
 				meshFilter.resource = "dragon.obj";
-				meshFilter.mesh = resourceManager.GetMesh(meshFilter.resource);
+				meshFilter.pendingMesh = resourceManager.GetMeshAsync(meshFilter.resource);
 
 				meshRenderer.resource = "#";
 				meshRenderer.texture = defaultTex;
 
 				meshRenderer.shaderResource = "opaque.glsl";
-				meshRenderer.shader = resourceManager.GetShader(meshRenderer.shaderResource);
+				meshRenderer.pendingShader = resourceManager.GetShaderAsync(meshRenderer.shaderResource);
+				meshRenderer.occluder = true;
 
-				transform.name = "dergon";
+				names.name = "dergon";
 				transform.transform.translation.z = -10;
 			}
 
@@ -331,73 +404,55 @@ namespace FoxEngine
 			{
 				entt::handle entity = { mRegistry, mRegistry.create() };
 				TransformComponent& transform = entity.emplace<TransformComponent>();
+				NameComponent& names = entity.emplace<NameComponent>();
 				MeshFilterComponent& meshFilter = entity.emplace<MeshFilterComponent>();
 				meshFilter.resource = "fox.obj";
-				meshFilter.mesh = resourceManager.GetMesh(meshFilter.resource);
-				transform.name = "foxo";
-				transform.tag = "__icon";
+				meshFilter.pendingMesh = resourceManager.GetMeshAsync(meshFilter.resource);
+				names.name = "foxo";
+				entity.emplace<IconTag>();
 				transform.transform.translation.z = -4;
 
 				MeshRendererComponent& meshRenderer = entity.emplace<MeshRendererComponent>();
 				meshRenderer.resource = "fox.png";
-				meshRenderer.texture = FoxEngine::Texture::Create(meshRenderer.resource).MakeUnique();
+				meshRenderer.pendingTexture = resourceManager.GetTextureAsync(meshRenderer.resource);
 
 				meshRenderer.shaderResource = "opaque.glsl";
-				meshRenderer.shader = resourceManager.GetShader(meshRenderer.shaderResource);
+				meshRenderer.pendingShader = resourceManager.GetShaderAsync(meshRenderer.shaderResource);
 
 				transform.transform.orientation = glm::rotate(transform.transform.orientation, glm::radians(180.f), glm::vec3(1, 0, 0));
 
 				foxEntity = entity;
 			}
 
+			FoxEngine::StateCacheOGL& stateCache = FoxEngine::StateCacheOGL::Get();
+			FoxEngine::StateCacheOGL::Stats stateCacheFrameStats;
+
 			glClearColor(0, 0, 0, 0);
 			glClearDepth(1);
-			glDepthFunc(GL_LEQUAL);
-			glEnable(GL_CULL_FACE);
-			glEnable(GL_DEPTH_TEST);
-			glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+			stateCache.DepthFunc(GL_LEQUAL);
+			stateCache.Enable(GL_CULL_FACE);
+			stateCache.Enable(GL_DEPTH_TEST);
+			stateCache.Enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 			glFrontFace(GL_CCW);
 			glCullFace(GL_BACK);
 			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-			glDisable(GL_MULTISAMPLE);
+			stateCache.Disable(GL_MULTISAMPLE);
 
-			unsigned int fbo = 0;
-			FoxEngine::Poly<FoxEngine::Texture> fboTex;
-			FoxEngine::Poly<FoxEngine::Texture> fboTexBlack;
-			FoxEngine::Poly<FoxEngine::Renderbuffer> fboDep;
-			int vpw = 0, vph = 0;
+			// Timestamps of the graph passes and the rest of the frame, shown in the GPU Profiler window
+			FoxEngine::GpuProfiler gpuProfiler;
+			std::string gpuProfilerSelection = "Frame";
 
+			FoxEngine::RenderGraph viewportGraph;
+			int vpw = 0, vph = 0;
+			viewportGraph.SetProfiler(&gpuProfiler);
 
-			unsigned int iconFbo;
-			FoxEngine::Poly<FoxEngine::Texture> iconTex;
-			FoxEngine::Poly<FoxEngine::Renderbuffer> iconDep;
+			FoxEngine::RenderGraph iconGraph;
 			int size = 64;
+			iconGraph.SetProfiler(&gpuProfiler);
 
-			iconTex = FoxEngine::Texture::Create(
-				{
-					.width = size,
-					.height = size,
-					.format = FoxEngine::ImageFormat::Rgba8,
-					.wrap = FoxEngine::Texture::Wrap::Clamp,
-					.min = FoxEngine::Texture::Filter::Nearest,
-					.mag = FoxEngine::Texture::Filter::Nearest,
-					.debugName = "icon color att 0"
-
-				});
-
-			iconDep = FoxEngine::Renderbuffer::Create(
-				{
-					.width = size,
-					.height = size,
-					.format = FoxEngine::ImageFormat::D24
-				});
-
-			glGenFramebuffers(1, &iconFbo);
-			glBindFramebuffer(GL_FRAMEBUFFER, iconFbo);
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, iconTex->Target(), iconTex->Handle(), 0);
-			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, iconDep->Handle());
+			// The icon only needs to land eventually, reading it back synchronously would wait for the whole frame
+			std::unique_ptr<FoxEngine::AsyncReadback> iconReadback = FoxEngine::AsyncReadback::Create({ .slots = 3, .debugName = "Icon readback" });
 
-			std::unique_ptr<char[]> pixels = std::make_unique<char[]>(size * size * 4);
 			glm::mat4 projection;
 
 			double lastTime = glfwGetTime();
@@ -409,18 +464,56 @@ namespace FoxEngine
 			bool showHierarchy = true;
 			bool showProperties = true;
 			bool showGpuInfo = false;
+			bool showGpuProfiler = false;
+			bool showStatistics = false;
+
+#if defined(FE_PROFILE)
+			bool showCpuProfiler = false;
+			bool cpuProfilerPaused = false;
+			int cpuProfilerFrames = 3;
+			std::vector<FoxEngine::CpuProfiler::ThreadEvents> cpuProfilerSnapshot;
+#endif
 
 			bool mouseLocked = false;
 
+			FE_PROFILE_THREAD("Main");
+
 			while (mRunning)
 			{
-				FoxEngine::Window::PollEvents();
-				mDispatcher.update();
+				FE_PROFILE_SCOPE("Frame");
+
+				{
+					FE_PROFILE_SCOPE("Poll events");
+					FoxEngine::Window::PollEvents();
+					mDispatcher.update();
+				}
+
+				gpuProfiler.BeginFrame();
 
 				currentTime = glfwGetTime();
 				deltaTime = currentTime - lastTime;
 				lastTime = currentTime;
 
+				// Gpu uploads for async loads, bounded so a burst of loads doesn't stall the frame
+				resourceManager.Update(std::chrono::milliseconds(2));
+
+				for (auto entity : mRegistry.view<MeshFilterComponent>())
+				{
+					auto& meshFilter = mRegistry.get<MeshFilterComponent>(entity);
+					if (resolve_pending(meshFilter.pendingMesh, meshFilter.mesh))
+						mRegistry.patch<MeshFilterComponent>(entity);
+				}
+
+				for (auto entity : mRegistry.view<MeshRendererComponent>())
+				{
+					auto& meshRenderer = mRegistry.get<MeshRendererComponent>(entity);
+					resolve_pending(meshRenderer.pendingShader, meshRenderer.shader);
+					resolve_pending(meshRenderer.pendingTexture, meshRenderer.texture);
+				}
+
+				UpdateTransforms();
+				SyncSceneTree();
+
 
 				static glm::vec2 last_mouse_pos{};
 
@@ -467,499 +560,1176 @@ namespace FoxEngine
 						
 				}
 
-				ImGui_ImplOpenGL3_NewFrame();
-				ImGui_ImplGlfw_NewFrame();
-				ImGui::NewFrame();
-
-				ImGui::DockSpaceOverViewport();
+				glm::mat4 cameraView = cameraTransform.ToInverseMatrix();
 
-				if (ImGui::BeginMainMenuBar())
+				// Viewport and icon rendering happen while the windows are built, they show up nested in here
 				{
-					if (ImGui::BeginMenu("File"))
+					FE_PROFILE_SCOPE("ImGui build");
+
+					ImGui_ImplOpenGL3_NewFrame();
+					ImGui_ImplGlfw_NewFrame();
+					ImGui::NewFrame();
+
+					ImGui::DockSpaceOverViewport();
+
+					if (ImGui::BeginMainMenuBar())
 					{
-						if (ImGui::MenuItem("Quit")) mRunning = false;
+						if (ImGui::BeginMenu("File"))
+						{
+							if (ImGui::MenuItem("Quit")) mRunning = false;
 						
-						ImGui::EndMenu();
-					}
+							ImGui::EndMenu();
+						}
 
-					if (ImGui::BeginMenu("View"))
-					{
-						ImGui::MenuItem("Viewport", nullptr, &showViewport);
-						ImGui::MenuItem("Hierarchy", nullptr, &showHierarchy);
-						ImGui::MenuItem("Properties", nullptr, &showProperties);
-						ImGui::MenuItem("GPU Info", nullptr, &showGpuInfo);		
-						ImGui::Separator();
-						ImGui::MenuItem("ImGui Demo Window", nullptr, &showDemoWindow);
-
-						ImGui::EndMenu();
+						if (ImGui::BeginMenu("View"))
+						{
+							ImGui::MenuItem("Viewport", nullptr, &showViewport);
+							ImGui::MenuItem("Hierarchy", nullptr, &showHierarchy);
+							ImGui::MenuItem("Properties", nullptr, &showProperties);
+							ImGui::MenuItem("GPU Info", nullptr, &showGpuInfo);
+							ImGui::MenuItem("GPU Profiler", nullptr, &showGpuProfiler);
+	#if defined(FE_PROFILE)
+							ImGui::MenuItem("CPU Profiler", nullptr, &showCpuProfiler);
+	#endif
+							ImGui::MenuItem("Statistics", nullptr, &showStatistics);
+							ImGui::Separator();
+							ImGui::MenuItem("ImGui Demo Window", nullptr, &showDemoWindow);
+
+							ImGui::EndMenu();
+						}
+
+						ImGui::EndMainMenuBar();
 					}
 
-					ImGui::EndMainMenuBar();
-				}
+					static float sun_time = 0;
+					static float sun_dist = 5;
 
-				static float sun_time = 0;
-				static float sun_dist = 5;
-				static int samples = 20;
+					// Taps of the radial blur, temporal accumulation makes up for a lower count
+					static int temporalSamples = 8;
+					static int plainSamples = 20;
 
-				{
-					if (ImGui::Begin("Lighting"))
 					{
-						ImGui::DragInt("Radial iterations", &samples, .1f, 0, 128);
-						ImGui::DragFloat("Sun time", &sun_time, 0.001f);
-						ImGui::DragFloat("Sun distance", &sun_dist, 0.01f, 0.1f, 500.0f);
+						if (ImGui::Begin("Lighting"))
+						{
+							ImGui::DragInt("Radial iterations", temporalShafts ? &temporalSamples : &plainSamples, .1f, 0, 128);
+							ImGui::DragFloat("Sun time", &sun_time, 0.001f);
+							ImGui::DragFloat("Sun distance", &sun_dist, 0.01f, 0.1f, 500.0f);
+
+							const char* qualities[] = { "Full", "Half", "Quarter" };
+							ImGui::Combo("Light shaft resolution", reinterpret_cast<int*>(&lightShaftQuality), qualities, 3);
+
+							if (ImGui::Checkbox("Temporal accumulation", &temporalShafts))
+								resetShaftHistory = true;
+
+							ImGui::SliderFloat("Temporal blend", &temporalBlend, 0.05f, 1.0f);
+
+							for (int i = 0; i < 3; ++i)
+							{
+								if (lightShaftTimers[i].HasResult())
+									ImGui::Text("%s: %.3f ms gpu", qualities[i], lightShaftTimers[i].Milliseconds());
+								else
+									ImGui::Text("%s: not measured yet", qualities[i]);
+							}
+						}
+						ImGui::End();
 					}
-					ImGui::End();
-				}
 
+					int samples = temporalShafts ? temporalSamples : plainSamples;
 
-				if (showDemoWindow)
-					ImGui::ShowDemoWindow(&showDemoWindow);
+					if (showDemoWindow)
+						ImGui::ShowDemoWindow(&showDemoWindow);
 
-				if (showViewport)
-				{
-					ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, { 0, 0 });
+					static entt::entity selected = entt::null;
 
-					ImGui::SetNextWindowViewport(ImGui::GetMainViewport()->ID);
+					if (showViewport)
+					{
+						ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, { 0, 0 });
+
+						ImGui::SetNextWindowViewport(ImGui::GetMainViewport()->ID);
 
 					
 
-					if (ImGui::Begin("Viewport", &showViewport))
-					{
+						if (ImGui::Begin("Viewport", &showViewport))
+						{
 						
 
-						if (!mouseLocked)
-						{
-							if (ImGui::IsWindowHovered() && ImGui::IsMouseDown(ImGuiMouseButton_Right))
+							if (!mouseLocked)
 							{
-								mouseLocked = true;
-								ImGui::SetWindowFocus();
-								glfwSetInputMode(mWindow.Handle(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-								ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_NoMouse;
-								ImGui::GetIO().ConfigFlags &= ~ImGuiConfigFlags_NavEnableKeyboard;
+								if (ImGui::IsWindowHovered() && ImGui::IsMouseDown(ImGuiMouseButton_Right))
+								{
+									mouseLocked = true;
+									ImGui::SetWindowFocus();
+									glfwSetInputMode(mWindow.Handle(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+									ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_NoMouse;
+									ImGui::GetIO().ConfigFlags &= ~ImGuiConfigFlags_NavEnableKeyboard;
+								}
 							}
-						}
-						else
-						{
-							if (!ImGui::IsMouseDown(ImGuiMouseButton_Right))
+							else
 							{
-								mouseLocked = false;
-								glfwSetInputMode(mWindow.Handle(), GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-								ImGui::GetIO().ConfigFlags &= ~ImGuiConfigFlags_NoMouse;
-								ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+								if (!ImGui::IsMouseDown(ImGuiMouseButton_Right))
+								{
+									mouseLocked = false;
+									glfwSetInputMode(mWindow.Handle(), GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+									ImGui::GetIO().ConfigFlags &= ~ImGuiConfigFlags_NoMouse;
+									ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+								}
 							}
-						}
 
-						ImVec2 size = ImGui::GetContentRegionAvail();
+							ImVec2 size = ImGui::GetContentRegionAvail();
 
-						if (size.x != 0 && size.y != 0)
-						{
-							// if size changed, resize is required
-							if (vpw != size.x || vph != size.y)
+							if (size.x != 0 && size.y != 0)
 							{
 								vpw = static_cast<int>(size.x);
 								vph = static_cast<int>(size.y);
 
-								if (fbo) glDeleteFramebuffers(1, &fbo);
-						
 								// TODO
 								//https://gitea.yiem.net/QianMo/Real-Time-Rendering-4th-Bibliography-Collection/raw/branch/main/Chapter%201-24/[0832]%20[SIGGRAPH%202014]%20Next%20Generation%20Post%20Processing%20in%20Call%20of%20Duty%20Advanced%20Warfare.pdf
 
-								fboTex = FoxEngine::Texture::Create(
-									{
-										.width = vpw,
-										.height = vph,
-										.format = FoxEngine::Texture::Format::Rgba8,
-										.wrap = FoxEngine::Texture::Wrap::Clamp,
-										.min = FoxEngine::Texture::Filter::Nearest,
-										.mag = FoxEngine::Texture::Filter::Nearest,
-										.debugName = "FBO color att 0"
-										
-									});
-
-								fboTexBlack = FoxEngine::Texture::Create(
+								// Rebuilt every frame, attachments come from the graph pool with headroom so dragging a dock splitter
+								// renders to a different sub-viewport instead of reallocating
+								viewportGraph.Reset();
+
+								FoxEngine::RenderGraph::TextureDesc colorDesc{ .width = vpw, .height = vph, .format = FoxEngine::ImageFormat::Rgba8 };
+								FoxEngine::RenderGraph::Resource sceneColor = viewportGraph.CreateTexture("Scene color", colorDesc);
+								FoxEngine::RenderGraph::Resource sunMask = viewportGraph.CreateTexture("Sun mask", colorDesc);
+								FoxEngine::RenderGraph::Resource sceneDepth = viewportGraph.CreateTexture("Scene depth", { .width = vpw, .height = vph, .format = FoxEngine::ImageFormat::D24 });
+
+								// Perform rendering
+								{
+									// projection resize should also be bound to window resize operations
+									projection = glm::perspectiveFov(glm::radians(90.0f), (float)vpw, (float)vph, nearPlane, farPlane);
+
+									viewportGraph.AddPass("Scene",
+										[&](FoxEngine::RenderGraph::PassBuilder& pass)
+										{
+											pass.WriteColor(0, sceneColor, true);
+											pass.WriteColor(1, sunMask, true);
+											pass.WriteDepth(sceneDepth, true);
+										},
+										[&](FoxEngine::RenderGraph&)
+										{
+											auto view = mRegistry.view<TransformComponent, MeshFilterComponent, MeshRendererComponent>(entt::exclude<IconTag>);
+
+											FoxEngine::Shader::CameraBlock camera = FoxEngine::Shader::CameraBlock::Make(cameraView, projection, cameraTransform.translation);
+											cameraBuffer->Upload(&camera, sizeof(camera));
+											cameraBuffer->BindBase(FoxEngine::Shader::CameraBinding);
+
+											sceneQueue.Clear();
+											sceneCandidates.clear();
+											cullingBatch.Clear();
+
+											{
+												FE_PROFILE_SCOPE("Culling");
+
+												FoxEngine::Frustum frustum = FoxEngine::Frustum::FromMatrix(camera.viewProjection);
+
+												auto addCandidate = [&](entt::entity entity)
+												{
+													auto [transform, meshFilter, meshRenderer] = view.get(entity);
+
+													if (!meshFilter.mesh) return;
+
+													FoxEngine::Shader* shader = meshRenderer.shader.get();
+
+													// Stand in while the real shader is still loading or compiling
+													if (!shader && meshRenderer.pendingShader.valid())
+														shader = fallbackShader.get();
+													else if (!meshRenderer.texture)
+														return;
+
+													if (!shader) return;
+
+													const glm::mat4& model = transform.world;
+
+													sceneCandidates.push_back({ shader, meshRenderer.texture.get(), meshFilter.mesh.get(), model, meshRenderer.occluder });
+
+													if (cullingMode == CullingMode::Linear)
+														cullingBatch.Add(meshFilter.mesh->GetBounds(), model);
+												};
+
+												if (cullingMode == CullingMode::Tree)
+												{
+													// The tree also holds entities without a renderer and icons, those are part of the rejected count
+													culledCount = mSceneTree.QueryFrustum(frustum, [&](std::uint32_t userData)
+														{
+															entt::entity entity = static_cast<entt::entity>(userData);
+
+															if (view.contains(entity))
+																addCandidate(entity);
+														});
+
+													cullingVisible.assign(sceneCandidates.size(), 1);
+													visibleCount = sceneCandidates.size();
+												}
+												else
+												{
+													for (auto entity : view)
+														addCandidate(entity);
+
+													if (cullingMode == CullingMode::Linear)
+													{
+														visibleCount = cullingBatch.Cull(frustum, cullingVisible);
+													}
+													else
+													{
+														cullingVisible.assign(sceneCandidates.size(), 1);
+														visibleCount = sceneCandidates.size();
+													}
+
+													culledCount = sceneCandidates.size() - visibleCount;
+												}
+
+												if (occlusionCulling)
+												{
+													FE_PROFILE_SCOPE("Occlusion culling");
+
+													auto occlusionStart = std::chrono::steady_clock::now();
+
+													occlusionBuffer.Begin(camera.viewProjection);
+
+													for (std::size_t i = 0; i < sceneCandidates.size(); ++i)
+														if (cullingVisible[i] && sceneCandidates[i].occluder)
+															occlusionBuffer.RasterizeOccluder(sceneCandidates[i].mesh->GetGeometry(), sceneCandidates[i].model);
+
+													occlusionBuffer.BuildHierarchy();
+
+													// Occluders are drawn regardless, they would mostly hide themselves
+													for (std::size_t i = 0; i < sceneCandidates.size(); ++i)
+													{
+														const SceneCandidate& candidate = sceneCandidates[i];
+														if (!cullingVisible[i] || candidate.occluder) continue;
+
+														if (!occlusionBuffer.IsVisible(FoxEngine::Aabb::FromBounds(candidate.mesh->GetBounds(), candidate.model)))
+														{
+															cullingVisible[i] = 0;
+															--visibleCount;
+															++culledCount;
+														}
+													}
+
+													occlusionMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - occlusionStart).count();
+												}
+											}
+
+											FE_PROFILE_SCOPE("Draw submission");
+
+											for (std::size_t i = 0; i < sceneCandidates.size(); ++i)
+											{
+												if (!cullingVisible[i]) continue;
+
+												const SceneCandidate& candidate = sceneCandidates[i];
+												float depth = -(camera.view * candidate.model[3]).z;
+
+												sceneQueue.Submit(FoxEngine::RenderQueue::Pass::Opaque, *candidate.shader, candidate.texture, *candidate.mesh, candidate.model, depth);
+											}
+
+											auto executeStart = std::chrono::steady_clock::now();
+											sceneQueue.Execute();
+											sceneExecuteMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - executeStart).count();
+										});
+
+									float sunStrength = 1.0f;
+									glm::vec2 sunCoordCenter{};
+
+									// Writes the sun to both outputs, the mask is what the radial blur spreads
+									viewportGraph.AddPass("Sun",
+										[&](FoxEngine::RenderGraph::PassBuilder& pass)
+										{
+											pass.WriteColor(0, sceneColor);
+											pass.WriteColor(1, sunMask);
+											pass.WriteDepth(sceneDepth);
+										},
+										[&](FoxEngine::RenderGraph&)
+										{
+											float local_time = sun_time * 3.141592f * 2.0f;
+
+											glm::vec3 sunDirection = glm::vec3(sin(local_time), sin(local_time) * 2, cos(local_time));
+											sunDirection = glm::normalize(sunDirection);
+
+											glm::mat4 viewM = cameraView;
+											viewM[3][0] = 0;
+											viewM[3][1] = 0;
+											viewM[3][2] = 0;
+
+											glm::vec3 targetPos = sunDirection * glm::vec3(2.0);
+											glm::vec4 viewSpace = viewM * glm::vec4(targetPos, 1.0f);
+											glm::vec4 clipSpace = projection * viewSpace;
+								
+											clipSpace /= clipSpace.w; // Perspective divide
+											sunCoordCenter = glm::vec2(clipSpace);
+
+											glm::mat4 pos = glm::identity<glm::mat4>();
+											//pos = glm::translate(pos, glm::vec3(glm::vec2(clipSpace), 0.0f));
+											pos = glm::translate(pos, sunDirection * sun_dist);
+									
+											glm::mat4 view = cameraView;
+
+											pos[0][0] = view[0][0];
+											pos[0][1] = view[1][0];
+											pos[0][2] = view[2][0];
+											pos[1][0] = view[0][1];
+											pos[1][1] = view[1][1];
+											pos[1][2] = view[2][1];
+											pos[2][0] = view[0][2];
+											pos[2][1] = view[1][2];
+											pos[2][2] = view[2][2];
+
+											// Draw sun
+											sunShader->Bind();
+											sunShader->Set(uSunProjection, projection);
+											sunShader->Set(uSunView, view);
+											sunShader->Set(uSunModel, pos);
+									
+											fsQuad->Draw();
+
+											// TODO: Add tonemapping
+											// https://www.shadertoy.com/view/ldcSRN
+											// https://www.shadertoy.com/view/fsXcz4
+											// https://www.shadertoy.com/view/4d3SR4
+										});
+
+									FoxEngine::GpuTimer& shaftTimer = lightShaftTimers[static_cast<int>(lightShaftQuality)];
+
+									if (lightShaftQuality == LightShaftQuality::Full && !temporalShafts)
 									{
-										.width = vpw,
-										.height = vph,
-										.format = FoxEngine::Texture::Format::Rgba8,
-										.wrap = FoxEngine::Texture::Wrap::Clamp,
-										.min = FoxEngine::Texture::Filter::Nearest,
-										.mag = FoxEngine::Texture::Filter::Nearest,
-										.debugName = "FBO color att 1"
+										viewportGraph.AddPass("Radial blur",
+											[&](FoxEngine::RenderGraph::PassBuilder& pass)
+											{
+												pass.Read(sunMask);
+												pass.WriteColor(0, sceneColor);
+											},
+											[&](FoxEngine::RenderGraph& graph)
+											{
+												shaftTimer.Begin();
+
+												stateCache.Disable(GL_DEPTH_TEST);
+												stateCache.Enable(GL_BLEND);
+												stateCache.BlendFunc(GL_ONE, GL_ONE);
+												stateCache.DepthMask(false);
+
+												// do radial blur
+												radialBlurShader->Bind();
+												radialBlurShader->Set(uBlurResolution, glm::vec2((float)vpw, (float)vph));
+												radialBlurShader->Set(uBlurUvScale, graph.UvScale(sunMask));
+												radialBlurShader->Set(uBlurCenter, sunCoordCenter * 0.5f + 0.5f);
+												radialBlurShader->Set(uBlurStrength, sunStrength);
+												radialBlurShader->Set(uBlurTime, (float)currentTime);
+												radialBlurShader->Set(uBlurIterations, (float)samples);
+							
+												graph.GetTexture(sunMask).Bind();
+												fsQuad->Draw();
 
-									});
+												stateCache.Disable(GL_BLEND);
+												stateCache.Enable(GL_DEPTH_TEST);
+												stateCache.DepthMask(true);
 
-								fboDep = FoxEngine::Renderbuffer::Create(
+												shaftTimer.End();
+											});
+									}
+									else
 									{
-										.width = vpw,
-										.height = vph,
-										.format = FoxEngine::ImageFormat::D24
-									});
+										int shaftScale = 1 << static_cast<int>(lightShaftQuality);
+										int shaftWidth = (vpw + shaftScale - 1) / shaftScale;
+										int shaftHeight = (vph + shaftScale - 1) / shaftScale;
+
+										FoxEngine::RenderGraph::TextureDesc shaftDesc{ .width = shaftWidth, .height = shaftHeight, .format = FoxEngine::ImageFormat::Rgba8, .filter = FoxEngine::Texture::Filter::Linear };
+										FoxEngine::RenderGraph::Resource shaftMask = viewportGraph.CreateTexture("Light shaft mask", shaftDesc);
+										FoxEngine::RenderGraph::Resource shaftDepth = viewportGraph.CreateTexture("Light shaft depth", { .width = shaftWidth, .height = shaftHeight, .format = FoxEngine::ImageFormat::R32f });
+										FoxEngine::RenderGraph::Resource shafts = viewportGraph.CreateTexture("Light shafts", shaftDesc);
+
+										// Passes run after this block, its locals are captured by value
+										viewportGraph.AddPass("Light shaft downsample",
+											[&](FoxEngine::RenderGraph::PassBuilder& pass)
+											{
+												pass.Read(sunMask);
+												pass.Read(sceneDepth);
+												pass.WriteColor(0, shaftMask);
+												pass.WriteColor(1, shaftDepth);
+											},
+											[&, shaftMask, shaftDepth, shaftScale](FoxEngine::RenderGraph& graph)
+											{
+												shaftTimer.Begin();
+
+												shaftDownsampleShader->Bind();
+												shaftDownsampleShader->Set(uDownsampleMask, 0);
+												shaftDownsampleShader->Set(uDownsampleDepth, 1);
+												shaftDownsampleShader->Set(uDownsampleResolution, glm::vec2((float)vpw, (float)vph));
+												shaftDownsampleShader->Set(uDownsampleScale, (float)shaftScale);
+												shaftDownsampleShader->Set(uDownsampleClipPlanes, glm::vec2(nearPlane, farPlane));
+
+												graph.GetTexture(sunMask).Bind(0);
+												graph.GetTexture(sceneDepth).Bind(1);
+												fsQuad->Draw();
+											});
+
+										viewportGraph.AddPass("Light shafts",
+											[&](FoxEngine::RenderGraph::PassBuilder& pass)
+											{
+												pass.Read(shaftMask);
+												pass.WriteColor(0, shafts);
+											},
+											[&, shaftMask, shaftWidth, shaftHeight](FoxEngine::RenderGraph& graph)
+											{
+												// Same blur as the full resolution path, over fewer pixels
+												radialBlurShader->Bind();
+												radialBlurShader->Set(uBlurResolution, glm::vec2((float)shaftWidth, (float)shaftHeight));
+												radialBlurShader->Set(uBlurUvScale, graph.UvScale(shaftMask));
+												radialBlurShader->Set(uBlurCenter, sunCoordCenter * 0.5f + 0.5f);
+												radialBlurShader->Set(uBlurStrength, sunStrength);
+												radialBlurShader->Set(uBlurTime, (float)currentTime);
+												radialBlurShader->Set(uBlurIterations, (float)samples);
+
+												graph.GetTexture(shaftMask).Bind(0);
+												fsQuad->Draw();
+											});
+
+										// What the upsample composites, the accumulated history when temporal
+										FoxEngine::RenderGraph::Resource composited = shafts;
+
+										if (temporalShafts)
+										{
+											glm::mat4 viewProjection = projection * cameraView;
+											glm::vec3 cameraForward = cameraTransform.orientation * glm::vec3(0.0f, 0.0f, -1.0f);
+
+											// Reprojection can't follow a teleport or a sharp turn, start over instead of smearing
+											bool cameraCut = glm::distance(cameraTransform.translation, previousCameraPosition) > 5.0f || glm::dot(cameraForward, previousCameraForward) < 0.8f;
+
+											FoxEngine::RenderGraph::TextureDesc historyDesc{ .width = shaftWidth, .height = shaftHeight, .format = FoxEngine::ImageFormat::Rgba16f, .filter = FoxEngine::Texture::Filter::Linear };
+											bool writeCreated = false, readCreated = false;
+
+											// Ping pong, last frame's target is read while the other one is written
+											FoxEngine::RenderGraph::Resource historyWrite = viewportGraph.CreatePersistentTexture(shaftHistoryIndex ? "Light shaft history 1" : "Light shaft history 0", historyDesc, &writeCreated);
+											FoxEngine::RenderGraph::Resource historyRead = viewportGraph.CreatePersistentTexture(shaftHistoryIndex ? "Light shaft history 0" : "Light shaft history 1", historyDesc, &readCreated);
+
+											bool reset = resetShaftHistory || cameraCut || writeCreated || readCreated || shaftWidth != shaftHistoryWidth || shaftHeight != shaftHistoryHeight;
+											glm::mat4 reprojection = previousViewProjection * glm::inverse(viewProjection);
+
+											viewportGraph.AddPass("Light shaft resolve",
+												[&](FoxEngine::RenderGraph::PassBuilder& pass)
+												{
+													pass.Read(shafts);
+													pass.Read(historyRead);
+													pass.Read(shaftDepth);
+													pass.WriteColor(0, historyWrite);
+												},
+												[&, shafts, historyRead, shaftDepth, shaftWidth, shaftHeight, reset, reprojection](FoxEngine::RenderGraph& graph)
+												{
+													shaftResolveShader->Bind();
+													shaftResolveShader->Set(uResolveCurrent, 0);
+													shaftResolveShader->Set(uResolveHistory, 1);
+													shaftResolveShader->Set(uResolveShaftDepth, 2);
+													shaftResolveShader->Set(uResolveReprojection, reprojection);
+													shaftResolveShader->Set(uResolveResolution, glm::vec2((float)shaftWidth, (float)shaftHeight));
+													shaftResolveShader->Set(uResolveHistoryUvScale, graph.UvScale(historyRead));
+													shaftResolveShader->Set(uResolveClipPlanes, glm::vec2(nearPlane, farPlane));
+													shaftResolveShader->Set(uResolveBlend, temporalBlend);
+													shaftResolveShader->Set(uResolveReset, reset ? 1.0f : 0.0f);
+
+													graph.GetTexture(shafts).Bind(0);
+													graph.GetTexture(historyRead).Bind(1);
+													graph.GetTexture(shaftDepth).Bind(2);
+													fsQuad->Draw();
+												});
+
+											composited = historyWrite;
+
+											shaftHistoryIndex ^= 1;
+											shaftHistoryWidth = shaftWidth;
+											shaftHistoryHeight = shaftHeight;
+											resetShaftHistory = false;
+											previousViewProjection = viewProjection;
+											previousCameraPosition = cameraTransform.translation;
+											previousCameraForward = cameraForward;
+										}
+
+										viewportGraph.AddPass("Light shaft upsample",
+											[&](FoxEngine::RenderGraph::PassBuilder& pass)
+											{
+												pass.Read(composited);
+												pass.Read(shaftDepth);
+												pass.Read(sceneDepth);
+												pass.WriteColor(0, sceneColor);
+											},
+											[&, composited, shaftDepth, shaftScale, shaftWidth, shaftHeight](FoxEngine::RenderGraph& graph)
+											{
+												stateCache.Disable(GL_DEPTH_TEST);
+												stateCache.Enable(GL_BLEND);
+												stateCache.BlendFunc(GL_ONE, GL_ONE);
+												stateCache.DepthMask(false);
+
+												shaftUpsampleShader->Bind();
+												shaftUpsampleShader->Set(uUpsampleShafts, 0);
+												shaftUpsampleShader->Set(uUpsampleShaftDepth, 1);
+												shaftUpsampleShader->Set(uUpsampleDepth, 2);
+												shaftUpsampleShader->Set(uUpsampleLowResolution, glm::vec2((float)shaftWidth, (float)shaftHeight));
+												shaftUpsampleShader->Set(uUpsampleScale, (float)shaftScale);
+												shaftUpsampleShader->Set(uUpsampleClipPlanes, glm::vec2(nearPlane, farPlane));
+
+												graph.GetTexture(composited).Bind(0);
+												graph.GetTexture(shaftDepth).Bind(1);
+												graph.GetTexture(sceneDepth).Bind(2);
+												fsQuad->Draw();
+
+												stateCache.Disable(GL_BLEND);
+												stateCache.Enable(GL_DEPTH_TEST);
+												stateCache.DepthMask(true);
+
+												shaftTimer.End();
+											});
+									}
+
+									viewportGraph.MarkOutput(sceneColor);
+
+									FE_PROFILE_SCOPE("Viewport graph");
+									FoxEngine::GpuProfiler::Scope scope(&gpuProfiler, "Viewport");
+									viewportGraph.Execute();
+								}
 
-								glGenFramebuffers(1, &fbo);
-								glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-								glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, fboTex->Target(), fboTex->Handle(), 0);
-								glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, fboTexBlack->Target(), fboTexBlack->Handle(), 0);
-								glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fboDep->Handle());
+								// Only the sub-viewport of the pooled texture was rendered to
+								glm::vec2 uvScale = viewportGraph.UvScale(sceneColor);
+								ImGui::Image((ImTextureID)(intptr_t)viewportGraph.GetTexture(sceneColor).Handle(), {(float)vpw, (float)vph}, {0, uvScale.y}, {uvScale.x, 0});
 
-								unsigned int vals[]{ GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-								glDrawBuffers(2, vals);
+								if (!mouseLocked && ImGui::IsItemClicked(ImGuiMouseButton_Left))
+								{
+									ImVec2 imageMin = ImGui::GetItemRectMin();
+									ImVec2 mouse = ImGui::GetMousePos();
 
+									glm::vec2 ndc = { (mouse.x - imageMin.x) / vpw * 2.0f - 1.0f, 1.0f - (mouse.y - imageMin.y) / vph * 2.0f };
+									selected = PickEntity(glm::inverse(projection * cameraView), ndc);
+								}
 							}
 
-							// Perform rendering
+
+						}
+						ImGui::End();
+
+						ImGui::PopStyleVar();
+					}
+
+					if (showHierarchy)
+					{
+						if (ImGui::Begin("Hierarchy", &showHierarchy))
+						{
+							if (ImGui::Button("Create entity"))
 							{
-								glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-								glViewport(0, 0, vpw, vph);
+								entt::handle entity = { mRegistry, mRegistry.create() };
+								entity.emplace<TransformComponent>();
+								entity.emplace<NameComponent>();
+							}
 
-								glClearColor(0, 0, 0, 0);
-								glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+							auto view = mRegistry.view<TransformComponent>();
 
-								// projection resize should also be bound to window resize operations
-								projection = glm::perspectiveFov(glm::radians(90.0f), (float)vpw, (float)vph, 0.1f, 1000.0f);
+							std::vector<entt::entity> roots;
+							std::unordered_map<entt::entity, std::vector<entt::entity>> children;
 
-								auto view = mRegistry.view<TransformComponent, MeshFilterComponent, MeshRendererComponent>();
+							for (auto entity : view)
+							{
+								entt::entity parent = view.get<TransformComponent>(entity).parent;
 
-								for (auto entity : view)
-								{
-									auto [transform, meshFilter, meshRenderer] = view.get(entity);
+								if (!HasTransform(parent))
+									roots.push_back(entity);
+								else
+									children[parent].push_back(entity);
+							}
 
-									if (!meshRenderer.texture) continue;
-									if (!meshRenderer.shader) continue;
-									if (!meshFilter.mesh) continue;
-									if (transform.tag == "__icon") continue;
+							// Applied after drawing, child is dropped onto parent
+							entt::entity dropChild = entt::null;
+							entt::entity dropParent = entt::null;
 
-									bool cullsBackFaces = meshRenderer.shader->CullsBackFaces();
+							auto drawNode = [&](auto& drawNode, entt::entity entity) -> void
+							{
+								const NameComponent& names = mRegistry.get<NameComponent>(entity);
+								auto found = children.find(entity);
+							 
+								ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanAvailWidth | ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_DefaultOpen;
+
+								if (found == children.end()) flags |= ImGuiTreeNodeFlags_Leaf;
+								if (entity == selected) flags |= ImGuiTreeNodeFlags_Selected;
+
+								ImGui::PushID((int)entity);
 
-									if (!cullsBackFaces)
-										glDisable(GL_CULL_FACE);
+								bool expanded = ImGui::TreeNodeEx(names.name.c_str(), flags);
 
-									meshRenderer.shader->Bind();
-									meshRenderer.shader->UniformMat4f("uProjection", glm::value_ptr(projection));
-									meshRenderer.shader->UniformMat4f("uView", glm::value_ptr(cameraTransform.ToInverseMatrix()));
-									meshRenderer.shader->UniformMat4f("uModel", glm::value_ptr(transform.transform.ToMatrix()));
 
-									meshRenderer.texture->Bind();
-									meshFilter.mesh->Draw();
+								if (ImGui::IsItemClicked())
+									selected = entity;
 
-									if (!cullsBackFaces)
-										glEnable(GL_CULL_FACE);
+								if (ImGui::BeginDragDropSource())
+								{
+									ImGui::SetDragDropPayload("FE_ENTITY", &entity, sizeof(entity));
+									ImGui::TextUnformatted(names.name.c_str());
+									ImGui::EndDragDropSource();
 								}
 
-								float sunStrength = 1.0f;
-								
-								glm::vec2 sunCoordCenter{};
+								if (ImGui::BeginDragDropTarget())
+								{
+									if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("FE_ENTITY"))
+									{
+										dropChild = *static_cast<const entt::entity*>(payload->Data);
+										dropParent = entity;
+									}
+
+									ImGui::EndDragDropTarget();
+								}
 
+								if (expanded)
 								{
-									float local_time = sun_time * 3.141592f * 2.0f;
+									if (found != children.end())
+										for (entt::entity child : found->second)
+											drawNode(drawNode, child);
 
-									glm::vec3 sunDirection = glm::vec3(sin(local_time), sin(local_time) * 2, cos(local_time));
-									sunDirection = glm::normalize(sunDirection);
+									ImGui::TreePop();
+								}
 
-									glm::mat4 viewM = cameraTransform.ToInverseMatrix();
-									viewM[3][0] = 0;
-									viewM[3][1] = 0;
-									viewM[3][2] = 0;
+								ImGui::PopID();
+							};
 
-									glm::vec3 targetPos = sunDirection * glm::vec3(2.0);
-									glm::vec4 viewSpace = viewM * glm::vec4(targetPos, 1.0f);
-									glm::vec4 clipSpace = projection * viewSpace;
-									
-									clipSpace /= clipSpace.w; // Perspective divide
-									sunCoordCenter = glm::vec2(clipSpace);
-
-									glm::mat4 pos = glm::identity<glm::mat4>();
-									//pos = glm::translate(pos, glm::vec3(glm::vec2(clipSpace), 0.0f));
-									pos = glm::translate(pos, sunDirection * sun_dist);
-										
-									glm::mat4 view = cameraTransform.ToInverseMatrix();
-
-									pos[0][0] = view[0][0];
-									pos[0][1] = view[1][0];
-									pos[0][2] = view[2][0];
-									pos[1][0] = view[0][1];
-									pos[1][1] = view[1][1];
-									pos[1][2] = view[2][1];
-									pos[2][0] = view[0][2];
-									pos[2][1] = view[1][2];
-									pos[2][2] = view[2][2];
-
-									// Draw sun
-									sunShader->Bind();
-									sunShader->UniformMat4f("uProjection", glm::value_ptr(projection));
-									sunShader->UniformMat4f("uView", glm::value_ptr(view));
-									sunShader->UniformMat4f("uModel", glm::value_ptr(pos));
-										
-									fsQuad->Draw();
-
-									// TODO: Add tonemapping
-									// https://www.shadertoy.com/view/ldcSRN
-									// https://www.shadertoy.com/view/fsXcz4
-									// https://www.shadertoy.com/view/4d3SR4
+							for (entt::entity root : roots)
+								drawNode(drawNode, root);
+
+							if (dropChild != entt::null && mRegistry.valid(dropChild))
+								SetParent(dropChild, dropParent);
+						}
+						ImGui::End();
+					}
+
+					if (showProperties)
+					{
+						if (ImGui::Begin("Properties", &showProperties))
+						{
+							if (selected != entt::null && mRegistry.valid(selected))
+							{
+								entt::handle handle = { mRegistry, selected };
+								TransformComponent& transform = handle.get<TransformComponent>();
+								NameComponent& names = handle.get<NameComponent>();
+				
+								ImGui::InputText("Name", &names.name);
+
+								if (transform.parent != entt::null && mRegistry.valid(transform.parent))
+								{
+									ImGui::Text("Parent: %s", mRegistry.get<NameComponent>(transform.parent).name.c_str());
+									ImGui::SameLine();
+
+									if (ImGui::Button("Unparent"))
+										SetParent(selected, entt::null);
 								}
+
+								if (ImGui::CollapsingHeader("Transform"))
+								{
+									ImGui::InputText("Tag", &names.tag);
+									ImGui::Separator();
+									bool transformChanged = ImGui::DragFloat3("Translation", glm::value_ptr(transform.transform.translation));
 								
-								glDisable(GL_DEPTH_TEST);
-								glEnable(GL_BLEND);
-								glBlendFunc(GL_ONE, GL_ONE);
-								glDisable(GL_DEPTH_TEST);
-								glDepthMask(GL_FALSE);
-
-								// do radial blur
-								radialBlurShader->Bind();
-								radialBlurShader->Uniform2f("uResolution", (float)vpw, (float)vph);
-								radialBlurShader->Uniform2f("uCenter", sunCoordCenter.x * 0.5f + 0.5f, sunCoordCenter.y * 0.5f + 0.5f);
-								radialBlurShader->Uniform1f("uStrength", sunStrength);
-								radialBlurShader->Uniform1f("uTime", (float)currentTime);
-								radialBlurShader->Uniform1f("uIterations", (float)samples);
-								
-								fboTexBlack->Bind();
+									glm::vec3 oldEuler = glm::degrees(glm::eulerAngles(transform.transform.orientation));
+									glm::vec3 euler = oldEuler;
+									bool changed = ImGui::DragFloat3("Orientation", glm::value_ptr(euler));
+									if (changed)
+									{
+										transformChanged = true;
+										glm::vec3 delta = glm::radians(euler - oldEuler);
+										transform.transform.orientation = glm::rotate(transform.transform.orientation, delta.x, glm::vec3(1, 0, 0));
+										transform.transform.orientation = glm::rotate(transform.transform.orientation, delta.y, glm::vec3(0, 1, 0));
+										transform.transform.orientation = glm::rotate(transform.transform.orientation, delta.z, glm::vec3(0, 0, 1));
+									}
+
+									transformChanged |= ImGui::DragFloat3("Scale", glm::value_ptr(transform.transform.scale));
+									if (ImGui::Button("Reset"))
+									{
+										transform.transform = Transform{};
+										transformChanged = true;
+									}
 
-								unsigned int bufs[] = { GL_COLOR_ATTACHMENT0 };
-								glDrawBuffers(1, bufs);
+									if (transformChanged)
+										mRegistry.patch<TransformComponent>(selected);
+								}
 
-								// render meshg
-								fsQuad->Draw();
+								if (auto* component = handle.try_get<MeshFilterComponent>())
+								{
+									if (ImGui::CollapsingHeader("Mesh filter"))
+									{
+										ImGui::InputText("Mesh", &component->resource);
+
+										ImGui::PushID(component);
+										if(ImGui::Button("Load"))
+											component->pendingMesh = resourceManager.GetMeshAsync(component->resource);
+										ImGui::PopID();
+
+										if (component->pendingMesh.valid())
+										{
+											ImGui::SameLine();
+											ImGui::TextUnformatted("Loading...");
+										}
+									}
+								}
+								else
+								{
+									if (ImGui::Button("Add Mesh filter"))
+									{
+										handle.emplace<MeshFilterComponent>();
+									}
+								}
 
-								unsigned int bufs2[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-								glDrawBuffers(2, bufs2);
-									
-								glDisable(GL_BLEND);
-								glEnable(GL_DEPTH_TEST);
-								glDepthMask(GL_TRUE);
+								if (auto* component = handle.try_get<MeshRendererComponent>())
+								{
+									if (ImGui::CollapsingHeader("Mesh renderer"))
+									{
+										ImGui::InputText("Texture", &component->resource);
+										ImGui::PushID(component);
+										if (ImGui::Button("Load"))
+											component->pendingTexture = resourceManager.GetTextureAsync(component->resource);
+										ImGui::PopID();
+
+										if (component->pendingTexture.valid())
+										{
+											ImGui::SameLine();
+											ImGui::TextUnformatted("Loading...");
+										}
+
+										ImGui::InputText("Shader", &component->shaderResource);
+										ImGui::InputText("Keywords", &component->shaderKeywords);
+										ImGui::Checkbox("Occluder", &component->occluder);
+										ImGui::PushID(component);
+										if (ImGui::Button("Load Shader"))
+											component->pendingShader = resourceManager.GetShaderAsync(component->shaderResource, component->shaderKeywords);
+										ImGui::PopID();
+
+										if (component->pendingShader.valid())
+										{
+											ImGui::SameLine();
+											ImGui::TextUnformatted("Loading...");
+										}
+									}
+								}
+								else
+								{
+									if (ImGui::Button("Add Mesh render"))
+									{
+										handle.emplace<MeshRendererComponent>();
+									}
+								}
+							
+							}
+							else
+							{
+								ImGui::TextUnformatted("No entity selected");
 							}
-
-							ImGui::Image((ImTextureID)(intptr_t)fboTex->Handle(), {(float)vpw, (float)vph}, {0, 1}, {1, 0});
 						}
-
-
+						ImGui::End();
 					}
-					ImGui::End();
 
-					ImGui::PopStyleVar();
-				}
+					if (showGpuInfo)
+					{
+						if(ImGui::Begin("GPU Debug info"))
+						{
+							ImGui::LabelText("Renderer", "%s", glGetString(GL_RENDERER));
+							ImGui::LabelText("Vendor", "%s", glGetString(GL_VENDOR));
+							ImGui::LabelText("Version", "%s", glGetString(GL_VERSION));
 
-				static entt::entity selected = entt::null;
+							if (ImGui::CollapsingHeader("Supported extensions"))
+							{
+								int numExts;
+								glGetIntegerv(GL_NUM_EXTENSIONS, &numExts);
 
-				if (showHierarchy)
-				{
-					if (ImGui::Begin("Hierarchy", &showHierarchy))
+								for (int i = 0; i < numExts; ++i)
+								{
+									ImGui::TextUnformatted((char*)glGetStringi(GL_EXTENSIONS, i));
+								}
+							}
+						
+						}
+						ImGui::End();
+					}
+
+					if (showGpuProfiler)
 					{
-						if (ImGui::Button("Create entity"))
+						if (ImGui::Begin("GPU Profiler", &showGpuProfiler))
 						{
-							entt::handle entity = { mRegistry, mRegistry.create() };
-							auto& transform = entity.emplace<TransformComponent>();
-							transform.name = "unnamed";
-						}
+							// Results are a few frames old, they come from the latest frame whose queries have finished
+							if (ImGui::BeginTable("Scopes", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+							{
+								ImGui::TableSetupColumn("Scope");
+								ImGui::TableSetupColumn("ms");
+								ImGui::TableSetupColumn("Average ms");
+								ImGui::TableHeadersRow();
 
-						auto view = mRegistry.view<TransformComponent>();
+								for (const FoxEngine::GpuProfiler::Result& result : gpuProfiler.Results())
+								{
+									const FoxEngine::GpuProfiler::History* history = gpuProfiler.GetHistory(result.name);
 
-						for (auto entity : view)
-						{
-							auto [transform] = view.get(entity);
-							 
-							ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_SpanAvailWidth;
+									ImGui::TableNextRow();
+									ImGui::TableNextColumn();
+									ImGui::PushID(&result);
 
-							if (entity == selected) flags |= ImGuiTreeNodeFlags_Selected;
+									// Nested scopes are indented under their parent, a zero indent would mean the default spacing
+									float indent = result.depth * ImGui::GetFontSize();
 
-							ImGui::PushID((int)entity);
+									if (indent > 0.0f)
+										ImGui::Indent(indent);
 
-							bool expanded = ImGui::TreeNodeEx(transform.name.c_str(), flags);
+									if (ImGui::Selectable(result.name.c_str(), result.name == gpuProfilerSelection, ImGuiSelectableFlags_SpanAllColumns))
+										gpuProfilerSelection = result.name;
 
+									if (indent > 0.0f)
+										ImGui::Unindent(indent);
 
-							if (ImGui::IsItemClicked())
-								selected = entity;
+									ImGui::PopID();
+									ImGui::TableNextColumn();
+									ImGui::Text("%.3f", result.milliseconds);
+									ImGui::TableNextColumn();
+									ImGui::Text("%.3f", history ? history->average : 0.0f);
+								}
 
-							if (expanded)
-							{
-								ImGui::TreePop();
+								ImGui::EndTable();
 							}
 
-							ImGui::PopID();
+							if (const FoxEngine::GpuProfiler::History* history = gpuProfiler.GetHistory(gpuProfilerSelection))
+							{
+								float peak = 0.0f;
+
+								for (float milliseconds : history->milliseconds)
+									peak = std::max(peak, milliseconds);
+
+								char overlay[128];
+								std::snprintf(overlay, sizeof(overlay), "%s: %.3f ms avg, %.3f ms peak", gpuProfilerSelection.c_str(), history->average, peak);
+								ImGui::PlotLines("##History", history->milliseconds.data(), static_cast<int>(history->milliseconds.size()), static_cast<int>(gpuProfiler.HistoryOffset()), overlay, 0.0f, peak * 1.2f + 0.01f, { ImGui::GetContentRegionAvail().x, 80.0f });
+							}
 						}
+						ImGui::End();
 					}
-					ImGui::End();
-				}
 
-				if (showProperties)
-				{
-					if (ImGui::Begin("Properties", &showProperties))
+	#if defined(FE_PROFILE)
+					if (showCpuProfiler)
 					{
-						if (selected != entt::null)
+						if (ImGui::Begin("CPU Profiler", &showCpuProfiler))
 						{
-							entt::handle handle = { mRegistry, selected };
-							TransformComponent& transform = handle.get<TransformComponent>();
-				
-							ImGui::InputText("Name", &transform.name);
+							FoxEngine::CpuProfiler& cpuProfiler = FoxEngine::CpuProfiler::Get();
 
-							if (ImGui::CollapsingHeader("Transform"))
+							ImGui::Checkbox("Pause", &cpuProfilerPaused);
+							ImGui::SameLine();
+							ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8.0f);
+							ImGui::SliderInt("Frames", &cpuProfilerFrames, 1, 8);
+							ImGui::SameLine();
+
+							// Everything the rings still hold, usually several seconds of the main thread
+							if (ImGui::Button("Export Chrome trace"))
+								cpuProfiler.ExportChromeTrace("cpu_trace.json");
+
+							// A second back is plenty for the frames shown and keeps the copy small
+							if (!cpuProfilerPaused)
+								cpuProfilerSnapshot = cpuProfiler.Snapshot(cpuProfiler.Now() - 1'000'000'000);
+
+							// The shown range spans the latest complete frames of the main thread
+							std::vector<const FoxEngine::CpuProfiler::Event*> frames;
+
+							for (const FoxEngine::CpuProfiler::ThreadEvents& thread : cpuProfilerSnapshot)
+								if (thread.name == "Main")
+									for (const FoxEngine::CpuProfiler::Event& event : thread.events)
+										if (event.depth == 0 && std::string_view(event.name) == "Frame")
+											frames.push_back(&event);
+
+							if (!frames.empty())
 							{
-								ImGui::InputText("Tag", &transform.tag);
-								ImGui::Separator();
-								ImGui::DragFloat3("Translation", glm::value_ptr(transform.transform.translation));
-								
-								glm::vec3 oldEuler = glm::degrees(glm::eulerAngles(transform.transform.orientation));
-								glm::vec3 euler = oldEuler;
-								bool changed = ImGui::DragFloat3("Orientation", glm::value_ptr(euler));
-								if (changed)
+								std::size_t firstFrame = frames.size() - std::min<std::size_t>(frames.size(), cpuProfilerFrames);
+								std::int64_t rangeStart = frames[firstFrame]->start;
+								std::int64_t rangeEnd = frames.back()->end;
+
+								ImGui::Text("Frame: %.3f ms", (frames.back()->end - frames.back()->start) / 1'000'000.0);
+
+								ImDrawList* drawList = ImGui::GetWindowDrawList();
+								float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+								float width = ImGui::GetContentRegionAvail().x;
+								double scale = width / static_cast<double>(std::max<std::int64_t>(rangeEnd - rangeStart, 1));
+
+								// One lane per thread, scopes stacked below their parent like a flame graph
+								for (const FoxEngine::CpuProfiler::ThreadEvents& thread : cpuProfilerSnapshot)
 								{
-									glm::vec3 delta = glm::radians(euler - oldEuler);
-									transform.transform.orientation = glm::rotate(transform.transform.orientation, delta.x, glm::vec3(1, 0, 0));
-									transform.transform.orientation = glm::rotate(transform.transform.orientation, delta.y, glm::vec3(0, 1, 0));
-									transform.transform.orientation = glm::rotate(transform.transform.orientation, delta.z, glm::vec3(0, 0, 1));
+									ImGui::TextUnformatted(thread.name.c_str());
+
+									ImVec2 origin = ImGui::GetCursorScreenPos();
+									std::uint32_t lanes = 1;
+
+									for (const FoxEngine::CpuProfiler::Event& event : thread.events)
+									{
+										if (event.end < rangeStart || event.start > rangeEnd)
+											continue;
+
+										float x0 = origin.x + static_cast<float>((std::max(event.start, rangeStart) - rangeStart) * scale);
+										float x1 = origin.x + static_cast<float>((std::min(event.end, rangeEnd) - rangeStart) * scale);
+										float y0 = origin.y + event.depth * rowHeight;
+										float y1 = y0 + rowHeight - 1.0f;
+										x1 = std::max(x1, x0 + 1.0f);
+
+										// Same hue for the same name on every thread and frame
+										float hue = static_cast<float>(std::hash<std::string_view>{}(event.name) % 360) / 360.0f;
+										drawList->AddRectFilled({ x0, y0 }, { x1, y1 }, ImColor::HSV(hue, 0.5f, 0.7f));
+
+										if (x1 - x0 > ImGui::GetFontSize())
+										{
+											drawList->PushClipRect({ x0, y0 }, { x1, y1 }, true);
+											drawList->AddText({ x0 + 2.0f, y0 }, IM_COL32_WHITE, event.name);
+											drawList->PopClipRect();
+										}
+
+										if (ImGui::IsMouseHoveringRect({ x0, y0 }, { x1, y1 }))
+											ImGui::SetTooltip("%s: %.3f ms", event.name, (event.end - event.start) / 1'000'000.0);
+
+										lanes = std::max(lanes, event.depth + 1);
+									}
+
+									ImGui::Dummy({ width, lanes * rowHeight });
 								}
+							}
+						}
+						ImGui::End();
+					}
+	#endif
+				
+					if (showStatistics)
+					{
+						if (ImGui::Begin("Statistics", &showStatistics))
+						{
+							if (ImGui::CollapsingHeader("Texture cache"))
+							{
+								const FoxEngine::CacheStats& stats = resourceManager.TextureStats();
+								std::size_t lookups = stats.hits + stats.misses;
 
-								ImGui::DragFloat3("Scale", glm::value_ptr(transform.transform.scale));
-								if (ImGui::Button("Reset"))
-									transform.transform = Transform{};
+								ImGui::Text("Hits: %zu", stats.hits);
+								ImGui::Text("Misses: %zu", stats.misses);
+								ImGui::Text("Hit rate: %.1f%%", lookups ? 100.0 * stats.hits / lookups : 0.0);
+								ImGui::Text("Resident: %zu textures, %.2f MiB", stats.residentCount, stats.residentBytes / (1024.0 * 1024.0));
 							}
 
-							if (auto* component = handle.try_get<MeshFilterComponent>())
+							if (ImGui::CollapsingHeader("Program binary cache"))
 							{
-								if (ImGui::CollapsingHeader("Mesh filter"))
-								{
-									ImGui::InputText("Mesh", &component->resource);
+								const FoxEngine::ProgramCacheOGL::Stats& stats = FoxEngine::ProgramCacheOGL::GetStats();
+								unsigned int lookups = stats.hits + stats.misses;
+
+								ImGui::Text("Supported: %s", FoxEngine::ProgramCacheOGL::IsSupported() ? "yes" : "no");
+								ImGui::Text("Hits: %u", stats.hits);
+								ImGui::Text("Misses: %u (%u rejected)", stats.misses, stats.rejected);
+								ImGui::Text("Hit rate: %.1f%%", lookups ? 100.0 * stats.hits / lookups : 0.0);
+								ImGui::Text("Time saved: %.2f ms", stats.savedMilliseconds);
+							}
 
-									ImGui::PushID(component);
-									if(ImGui::Button("Load"))
-										component->mesh = resourceManager.GetMesh(component->resource);
-									ImGui::PopID();
-								}
+							ImGui::Text("Pending uploads: %zu", resourceManager.PendingUploads());
+							ImGui::Text("Compiling shaders: %zu", resourceManager.CompilingShaders());
+
+							if (ImGui::CollapsingHeader("GL state cache"))
+							{
+								unsigned int calls = stateCacheFrameStats.issued + stateCacheFrameStats.skipped;
+
+								ImGui::Text("Issued: %u", stateCacheFrameStats.issued);
+								ImGui::Text("Skipped: %u", stateCacheFrameStats.skipped);
+								ImGui::Text("Skip rate: %.1f%%", calls ? 100.0 * stateCacheFrameStats.skipped / calls : 0.0);
 							}
-							else
+
+							if (ImGui::CollapsingHeader("Render graph"))
 							{
-								if (ImGui::Button("Add Mesh filter"))
+								auto graphStats = [](const char* label, const FoxEngine::RenderGraph::Stats& stats)
 								{
-									handle.emplace<MeshFilterComponent>();
-								}
+									ImGui::Text("%s", label);
+									ImGui::Text("Passes: %u (%u culled)", stats.passes, stats.culledPasses);
+									ImGui::Text("Resources: %u virtual, %u pooled, %u persistent", stats.resources, stats.physicalResources, stats.persistentResources);
+									ImGui::Text("Allocations: %u (%u total)", stats.allocations, stats.totalAllocations);
+									ImGui::Text("Framebuffers: %u (%u binds)", stats.framebuffers, stats.framebufferBinds);
+								};
+
+								graphStats("Viewport", viewportGraph.GetStats());
+								ImGui::Separator();
+								graphStats("Window icon (last update)", iconGraph.GetStats());
+
+								const FoxEngine::AsyncReadback::Stats& readback = iconReadback->GetStats();
+								ImGui::Text("Readbacks: %llu completed, %llu dropped, %llu failed, %u in flight", (unsigned long long)readback.completed, (unsigned long long)readback.dropped, (unsigned long long)readback.failed, iconReadback->Pending());
 							}
 
-							if (auto* component = handle.try_get<MeshRendererComponent>())
+							if (ImGui::CollapsingHeader("Transforms"))
 							{
-								if (ImGui::CollapsingHeader("Mesh renderer"))
-								{
-									ImGui::InputText("Texture", &component->resource);
-									ImGui::PushID(component);
-									if (ImGui::Button("Load"))
-										component->texture = FoxEngine::Texture::Create(component->resource).MakeUnique();
-									ImGui::PopID();
+								ImGui::Text("Transforms: %zu", mRegistry.storage<TransformComponent>().size());
+								ImGui::Text("Last batch: %zu local matrices", mTransformBatch.Size());
+							}
 
-									ImGui::InputText("Shader", &component->shaderResource);
-									ImGui::PushID(component);
-									if (ImGui::Button("Load Shader"))
-										component->shader = resourceManager.GetShader(component->shaderResource);
-									ImGui::PopID();
-								}
+							if (ImGui::CollapsingHeader("Culling"))
+							{
+								const char* modes[] = { "None", "Linear (batched)", "Scene tree" };
+								ImGui::Combo("Frustum culling", reinterpret_cast<int*>(&cullingMode), modes, 3);
+								ImGui::Text("Visible: %zu", visibleCount);
+								ImGui::Text("Culled: %zu", culledCount);
+
+								ImGui::Separator();
+								ImGui::Text("Scene tree proxies: %zu", mSceneTree.ProxyCount());
+								ImGui::Text("Nodes: %zu", mSceneTree.NodeCount());
+								ImGui::Text("Height: %d", mSceneTree.Height());
+
+								ImGui::Separator();
+
+								const FoxEngine::OcclusionBuffer::Stats& occlusion = occlusionBuffer.GetStats();
+
+								ImGui::Checkbox("Occlusion culling", &occlusionCulling);
+								ImGui::Text("Occluders: %u (%u triangles)", occlusion.occluders, occlusion.triangles);
+								ImGui::Text("Occluded: %u of %u tested", occlusion.occluded, occlusion.tested);
+								ImGui::Text("Cpu time: %.3f ms", occlusionMilliseconds);
 							}
-							else
+
+							if (ImGui::CollapsingHeader("Render queue"))
 							{
-								if (ImGui::Button("Add Mesh render"))
+								const FoxEngine::RenderQueue::Stats& stats = sceneQueue.GetStats();
+
+								bool instancing = sceneQueue.Instancing();
+								if (ImGui::Checkbox("Instancing", &instancing))
+									sceneQueue.SetInstancing(instancing);
+
+								ImGui::Text("Execute: %.3f ms", sceneExecuteMilliseconds);
+								ImGui::Text("Draw calls: %u (%u instances)", stats.draws, stats.instances);
+								ImGui::Text("State changes: %u", stats.StateChanges());
+								ImGui::Text("Shader binds: %u", stats.shaderBinds);
+								ImGui::Text("Texture binds: %u", stats.textureBinds);
+								ImGui::Text("Mesh binds: %u", stats.meshBinds);
+								ImGui::Text("Cull toggles: %u", stats.cullToggles);
+
+								// Identical props, the case instancing is meant for
+								ImGui::SliderInt("Stress grid", &stressGridSize, 1, 128);
+
+								if (ImGui::Button("Spawn"))
 								{
-									handle.emplace<MeshRendererComponent>();
+									for (int x = 0; x < stressGridSize; ++x)
+									{
+										for (int z = 0; z < stressGridSize; ++z)
+										{
+											entt::handle entity = { mRegistry, mRegistry.create() };
+											TransformComponent& transform = entity.emplace<TransformComponent>();
+											NameComponent& names = entity.emplace<NameComponent>();
+											names.name = "stress pine";
+											names.tag = "__stress";
+											transform.transform.translation = glm::vec3(x - stressGridSize * 0.5f, -2.0f, -z - 5.0f) * 2.0f;
+
+											MeshFilterComponent& meshFilter = entity.emplace<MeshFilterComponent>();
+											meshFilter.resource = "pine.obj";
+											meshFilter.pendingMesh = resourceManager.GetMeshAsync(meshFilter.resource);
+
+											MeshRendererComponent& meshRenderer = entity.emplace<MeshRendererComponent>();
+											meshRenderer.resource = "pine.png";
+											meshRenderer.pendingTexture = resourceManager.GetTextureAsync(meshRenderer.resource);
+											meshRenderer.shaderResource = "cutout.glsl";
+											meshRenderer.pendingShader = resourceManager.GetShaderAsync(meshRenderer.shaderResource);
+										}
+									}
+								}
+
+								ImGui::SameLine();
+
+								if (ImGui::Button("Clear"))
+								{
+									auto view = mRegistry.view<NameComponent>();
+
+									// Destroying the current entity while iterating a view is allowed by entt
+									for (auto entity : view)
+										if (view.get<NameComponent>(entity).tag == "__stress")
+											mRegistry.destroy(entity);
 								}
 							}
-							
-						}
-						else
-						{
-							ImGui::TextUnformatted("No entity selected");
 						}
+						ImGui::End();
 					}
-					ImGui::End();
-				}
 
-				if (showGpuInfo)
-				{
-					if(ImGui::Begin("GPU Debug info"))
+					// Use callbacks for this, no neeed to do this every frame,
+					// later on this will trigger buffer and texture reallocation
+					int w, h;
+					glfwGetFramebufferSize(mWindow.Handle(), &w, &h);
+
+
+					if (w != 0 && h != 0)
 					{
-						ImGui::LabelText("Renderer", "%s", glGetString(GL_RENDERER));
-						ImGui::LabelText("Vendor", "%s", glGetString(GL_VENDOR));
-						ImGui::LabelText("Version", "%s", glGetString(GL_VERSION));
+						static double rotateDelta = 0.0;
+						rotateDelta += deltaTime;
 
-						if (ImGui::CollapsingHeader("Supported extensions"))
-						{
-							int numExts;
-							glGetIntegerv(GL_NUM_EXTENSIONS, &numExts);
+						static double timer = 0.0;
+						timer += deltaTime;
 
-							for (int i = 0; i < numExts; ++i)
+						iconReadback->Poll([&](const FoxEngine::AsyncReadback::Result& result)
 							{
-								ImGui::TextUnformatted((char*)glGetStringi(GL_EXTENSIONS, i));
-							}
-						}
-						
-					}
-					ImGui::End();
-				}
-				
-				// Use callbacks for this, no neeed to do this every frame,
-				// later on this will trigger buffer and texture reallocation
-				int w, h;
-				glfwGetFramebufferSize(mWindow.Handle(), &w, &h);
+								GLFWimage image;
+								image.width = result.width;
+								image.height = result.height;
+								image.pixels = const_cast<unsigned char*>(result.pixels.data());
 
+								glfwSetWindowIcon(mWindow.Handle(), 1, &image);
+							});
 
-				if (w != 0 && h != 0)
-				{
-					static double rotateDelta = 0.0;
-					rotateDelta += deltaTime;
+						if (timer > 1.0 / 8.0)
+						{
+							timer = 0.0;
 
-					static double timer = 0.0;
-					timer += deltaTime;
+							// Rotate foxo
+							Transform& t = foxEntity.get<TransformComponent>().transform;
+							t.orientation = glm::rotate(t.orientation, (float)glm::radians(45.0 * rotateDelta), glm::vec3(0, 1, 0));
+							mRegistry.patch<TransformComponent>(foxEntity);
+							UpdateTransforms(); // The icon below is drawn with the new world matrix
+							rotateDelta = 0.0;
 
-					if (timer > 1.0 / 8.0)
-					{
-						timer = 0.0;
+							iconGraph.Reset();
 
-						// Rotate foxo
-						Transform& t = foxEntity.get<TransformComponent>().transform;
-						t.orientation = glm::rotate(t.orientation, (float)glm::radians(45.0 * rotateDelta), glm::vec3(0, 1, 0));
-						rotateDelta = 0.0;
+							FoxEngine::RenderGraph::Resource iconColor = iconGraph.CreateTexture("Icon color", { .width = size, .height = size, .format = FoxEngine::ImageFormat::Rgba8 });
+							FoxEngine::RenderGraph::Resource iconDepth = iconGraph.CreateTexture("Icon depth", { .width = size, .height = size, .format = FoxEngine::ImageFormat::D24 });
 
-						glBindRenderbuffer(GL_RENDERBUFFER, 0);
-						glBindTexture(GL_TEXTURE_2D, 0);
-						glBindFramebuffer(GL_FRAMEBUFFER, iconFbo);
-						glViewport(0, 0, size, size);
+							iconGraph.AddPass("Icon",
+								[&](FoxEngine::RenderGraph::PassBuilder& pass)
+								{
+									pass.WriteColor(0, iconColor, true);
+									pass.WriteDepth(iconDepth, true);
+									pass.SideEffect(); // Nothing in the graph consumes the icon, only the readback
+								},
+								[&](FoxEngine::RenderGraph&)
+								{
+									auto view = mRegistry.view<IconTag, TransformComponent, MeshFilterComponent, MeshRendererComponent>();
 
-						glClearColor(0, 0, 0, 0);
-						glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+									// Replaces the scene camera, the next frame uploads it again
+									FoxEngine::Shader::CameraBlock camera = FoxEngine::Shader::CameraBlock::Make(glm::identity<glm::mat4>(), glm::perspectiveFov(glm::radians(60.0f), (float)size, (float)size, 0.01f, 10.0f), glm::vec3(0.0f));
+									cameraBuffer->Upload(&camera, sizeof(camera));
+									cameraBuffer->BindBase(FoxEngine::Shader::CameraBinding);
 
-						auto view = mRegistry.view<TransformComponent, MeshFilterComponent, MeshRendererComponent>();
+									iconQueue.Clear();
 
-						for (auto entity : view)
-						{
-							auto [transform, meshFilter, meshRenderer] = view.get(entity);
+									for (auto entity : view)
+									{
+										auto [transform, meshFilter, meshRenderer] = view.get<TransformComponent, MeshFilterComponent, MeshRendererComponent>(entity);
 
-							if (transform.tag != "__icon") continue;
+										if (!meshRenderer.texture) continue;
+										if (!meshRenderer.shader) continue;
+										if (!meshFilter.mesh) continue;
 
-							meshRenderer.shader->Bind();
-							meshRenderer.shader->UniformMat4f("uProjection", glm::value_ptr(glm::perspectiveFov(glm::radians(60.0f), (float)size, (float)size, 0.01f, 10.0f)));
-							meshRenderer.shader->UniformMat4f("uView", glm::value_ptr(glm::identity<glm::mat4>()));
-							meshRenderer.shader->UniformMat4f("uModel", glm::value_ptr(transform.transform.ToMatrix()));
+										const glm::mat4& model = transform.world;
+										iconQueue.Submit(FoxEngine::RenderQueue::Pass::Opaque, *meshRenderer.shader, meshRenderer.texture.get(), *meshFilter.mesh, model, -model[3].z);
+									}
 
-							meshRenderer.texture->Bind();
-							meshFilter.mesh->Draw();
-						}
+									iconQueue.Execute();
 
-						iconTex->Bind();
-						glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.get());
+									// Completes a few frames later, see the poll above
+									iconReadback->Read(0, 0, size, size);
+								});
 
-						GLFWimage image;
-						image.width = size;
-						image.height = size;
-						image.pixels = (unsigned char*)pixels.get();
+							FE_PROFILE_SCOPE("Window icon");
+							FoxEngine::GpuProfiler::Scope scope(&gpuProfiler, "Window icon");
+							iconGraph.Execute();
+						}
+					}
 
-						glfwSetWindowIcon(mWindow.Handle(), 1, &image);
+					stateCache.BindFramebuffer(0);
+					stateCache.BindTexture(0, GL_TEXTURE_2D, 0);
 
-					}
+					ImGui::Render();
 				}
 
-				glBindFramebuffer(GL_FRAMEBUFFER, 0);
-				glBindTexture(GL_TEXTURE_2D, 0);
-
-				ImGui::Render();
 				int display_w, display_h;
 				glfwGetFramebufferSize(mWindow.Handle(), &display_w, &display_h);
 				glViewport(0, 0, display_w, display_h);
 				glClearColor(0, 0, 0, 1);
 				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-				ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+				{
+					FE_PROFILE_SCOPE("ImGui render");
+					FoxEngine::GpuProfiler::Scope scope(&gpuProfiler, "ImGui");
+					ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+				}
 
 				// Update and Render additional Platform Windows
 				// (Platform functions may change the current OpenGL context, so we save/restore it to make it easier to paste this code elsewhere.
@@ -972,7 +1742,18 @@ namespace FoxEngine
 					glfwMakeContextCurrent(backup_current_context);
 				}
 
-				mWindow.SwapBuffers();
+				// Imgui restores the state it changes, starting every frame from a clean cache guards against anything that does not
+				stateCacheFrameStats = stateCache.GetStats();
+				stateCache.ResetStats();
+				stateCache.Invalidate();
+
+				// Queries belong to the main context, which the platform windows above have made current again
+				gpuProfiler.EndFrame();
+
+				{
+					FE_PROFILE_SCOPE("Swap buffers");
+					mWindow.SwapBuffers();
+				}
 			}
 
 			mDispatcher.disconnect(this);
@@ -992,12 +1773,233 @@ namespace FoxEngine
 		{
 			mRunning = false;
 		}	
+
+		void OnTransformChanged(entt::registry& registry, entt::entity entity)
+		{
+			registry.get<TransformComponent>(entity).dirty = true;
+		}
+
+		void OnTransformDestroyed(entt::registry& registry, entt::entity entity)
+		{
+			OnBoundsDestroyed(registry, entity);
+
+			// Removal moves another component into the hole, which can put a child before its parent
+			mHierarchyChanged = true;
+		}
+
+		// Keeps the world transform of entity. Returns false if parent has no transform, or is entity or one of its descendants
+		bool SetParent(entt::entity entity, entt::entity parent)
+		{
+			if (parent != entt::null && !HasTransform(parent)) return false;
+
+			for (entt::entity ancestor = parent; HasTransform(ancestor); ancestor = mRegistry.get<TransformComponent>(ancestor).parent)
+				if (ancestor == entity) return false;
+
+			TransformComponent& transform = mRegistry.get<TransformComponent>(entity);
+			glm::mat4 parentWorld = parent == entt::null ? glm::identity<glm::mat4>() : CurrentWorld(parent);
+
+			transform.transform.FromMatrix(glm::inverse(parentWorld) * CurrentWorld(entity));
+			transform.parent = parent;
+			mRegistry.patch<TransformComponent>(entity);
+
+			mHierarchyChanged = true;
+			return true;
+		}
+
+		// Recomputes the local matrices of patched transforms and the world matrices below them. The local matrix
+		// is the same as Transform::ToMatrix, orientation normalized included, which stays for one off use.
+		// The storage is kept sorted by depth so every parent is updated before its children
+		void UpdateTransforms()
+		{
+			if (mHierarchyChanged)
+			{
+				SortHierarchy();
+				mHierarchyChanged = false;
+			}
+
+			auto view = mRegistry.view<TransformComponent>();
+
+			// Local matrices first, composed in batches of 8 from packed arrays
+			mTransformBatch.Clear();
+			mBatchedTransforms.clear();
+
+			for (auto entity : view)
+			{
+				TransformComponent& transform = view.get<TransformComponent>(entity);
+				if (!transform.dirty) continue;
+
+				mTransformBatch.Add(transform.transform.translation, glm::normalize(transform.transform.orientation), transform.transform.scale);
+				mBatchedTransforms.push_back(&transform);
+			}
+
+			mComposedMatrices.resize(mTransformBatch.Size());
+			mTransformBatch.Compose(mComposedMatrices.data());
+
+			for (std::size_t i = 0; i < mBatchedTransforms.size(); ++i)
+				mBatchedTransforms[i]->local = mComposedMatrices[i];
+
+			for (auto entity : view)
+			{
+				TransformComponent& transform = view.get<TransformComponent>(entity);
+				const TransformComponent* parent = transform.parent == entt::null ? nullptr : &view.get<TransformComponent>(transform.parent);
+
+				transform.worldChanged = transform.dirty || (parent && parent->worldChanged);
+				if (!transform.worldChanged) continue;
+
+				transform.dirty = false;
+				transform.world = parent ? parent->world * transform.local : transform.local;
+				mDirtyBounds.push_back(entity);
+			}
+		}
+
+		bool HasTransform(entt::entity entity) const
+		{
+			return entity != entt::null && mRegistry.valid(entity) && mRegistry.all_of<TransformComponent>(entity);
+		}
+
+		// World matrix from the transforms as they are now, the cached one is only current after UpdateTransforms
+		glm::mat4 CurrentWorld(entt::entity entity) const
+		{
+			glm::mat4 world = glm::identity<glm::mat4>();
+
+			for (entt::entity ancestor = entity; HasTransform(ancestor); ancestor = mRegistry.get<TransformComponent>(ancestor).parent)
+				world = mRegistry.get<TransformComponent>(ancestor).transform.ToMatrix() * world;
+
+			return world;
+		}
+
+		void SortHierarchy()
+		{
+			auto view = mRegistry.view<TransformComponent>();
+
+			// Children of destroyed entities, or of entities that lost their transform, become roots where they are.
+			// Their last world matrix is still valid
+			for (auto entity : view)
+			{
+				TransformComponent& transform = view.get<TransformComponent>(entity);
+				if (transform.parent == entt::null || HasTransform(transform.parent)) continue;
+
+				transform.parent = entt::null;
+				transform.transform.FromMatrix(transform.world);
+				transform.dirty = true;
+			}
+
+			for (auto entity : view)
+			{
+				TransformComponent& transform = view.get<TransformComponent>(entity);
+
+				transform.depth = 0;
+				for (entt::entity ancestor = transform.parent; HasTransform(ancestor); ancestor = view.get<TransformComponent>(ancestor).parent)
+					++transform.depth;
+			}
+
+			mRegistry.sort<TransformComponent>([](const TransformComponent& lhs, const TransformComponent& rhs) { return lhs.depth < rhs.depth; });
+		}
+
+		void OnBoundsChanged(entt::registry&, entt::entity entity)
+		{
+			mDirtyBounds.push_back(entity);
+		}
+
+		void OnBoundsDestroyed(entt::registry&, entt::entity entity)
+		{
+			auto it = mSceneProxies.find(entity);
+			if (it == mSceneProxies.end()) return;
+
+			mSceneTree.Remove(it->second);
+			mSceneProxies.erase(it);
+		}
+
+		// Brings the scene tree up to date with the entities changed since the last call
+		void SyncSceneTree()
+		{
+			for (entt::entity entity : mDirtyBounds)
+			{
+				if (!mRegistry.valid(entity)) continue;
+
+				auto* transform = mRegistry.try_get<TransformComponent>(entity);
+				auto* meshFilter = mRegistry.try_get<MeshFilterComponent>(entity);
+				auto it = mSceneProxies.find(entity);
+
+				// Entities join the tree once their mesh has loaded
+				if (!transform || !meshFilter || !meshFilter->mesh)
+				{
+					if (it != mSceneProxies.end())
+					{
+						mSceneTree.Remove(it->second);
+						mSceneProxies.erase(it);
+					}
+
+					continue;
+				}
+
+				FoxEngine::Aabb box = FoxEngine::Aabb::FromBounds(meshFilter->mesh->GetBounds(), transform->world);
+
+				if (it == mSceneProxies.end())
+					mSceneProxies.emplace(entity, mSceneTree.Insert(box, static_cast<std::uint32_t>(entity)));
+				else
+					mSceneTree.Move(it->second, box);
+			}
+
+			mDirtyBounds.clear();
+		}
+
+		// Closest entity whose world box is under the cursor, ndc in [-1, 1] with y up
+		entt::entity PickEntity(const glm::mat4& inverseViewProjection, glm::vec2 ndc)
+		{
+			glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+			glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+
+			glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+			glm::vec3 ray = glm::vec3(farPoint) / farPoint.w - origin;
+			float length = glm::length(ray);
+			glm::vec3 direction = ray / length;
+			glm::vec3 inverseDirection = 1.0f / direction;
+
+			entt::entity closest = entt::null;
+			float closestDistance = length;
+
+			// The tree holds enlarged boxes, hits are confirmed against the exact world box
+			mSceneTree.RayCast(origin, direction, length, [&](std::uint32_t userData, float)
+				{
+					entt::entity entity = static_cast<entt::entity>(userData);
+					const TransformComponent& transform = mRegistry.get<TransformComponent>(entity);
+					const MeshFilterComponent& meshFilter = mRegistry.get<MeshFilterComponent>(entity);
+
+					if (mRegistry.all_of<IconTag>(entity)) return closestDistance;
+
+					FoxEngine::Aabb box = FoxEngine::Aabb::FromBounds(meshFilter.mesh->GetBounds(), transform.world);
+
+					float distance;
+					if (box.RayIntersect(origin, inverseDirection, closestDistance, distance))
+					{
+						closest = entity;
+						closestDistance = distance;
+					}
+
+					return closestDistance;
+				});
+
+			return closest;
+		}
 	public:
 		bool mRunning = true;
 		FoxEngine::Window mWindow;
 		entt::registry mRegistry;
 
 		entt::dispatcher mDispatcher{};
+
+		// World boxes of every entity with a transform and a loaded mesh, kept in sync by the registry observers
+		FoxEngine::AabbTree mSceneTree;
+		std::unordered_map<entt::entity, int> mSceneProxies;
+		std::vector<entt::entity> mDirtyBounds;
+
+		bool mHierarchyChanged = false;
+
+		// Scratch for UpdateTransforms, kept to reuse the allocations
+		FoxEngine::TransformBatch mTransformBatch;
+		std::vector<TransformComponent*> mBatchedTransforms;
+		std::vector<glm::mat4> mComposedMatrices;
 	};
 }
 
@@ -1034,6 +2036,17 @@ int main(int argc, char* argv[])
 	FoxEngine::Log::Info("Welcome to FoxEngine");
 
 	RedirectWorkingDirectory();
+
+	// Offline cook step: game --cook fox.obj pine.obj ...
+	if (argc > 1 && std::string_view(argv[1]) == "--cook")
+	{
+		int failures = 0;
+
+		for (int i = 2; i < argc; ++i)
+			if (!FoxEngine::MeshLoader::Cook(argv[i])) ++failures;
+
+		return failures == 0 ? 0 : 1;
+	}
 	
 	stbi_set_flip_vertically_on_load(true);
 
@@ -0,0 +1,299 @@
+#include "AabbTree.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace FoxEngine
+{
+	Aabb Aabb::FromBounds(const Mesh::Bounds& bounds, const glm::mat4& world)
+	{
+		glm::vec3 localCenter = (bounds.min + bounds.max) * 0.5f;
+		glm::vec3 localExtent = (bounds.max - bounds.min) * 0.5f;
+
+		glm::vec3 center = glm::vec3(world * glm::vec4(localCenter, 1.0f));
+		glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(world[0])), glm::abs(glm::vec3(world[1])), glm::abs(glm::vec3(world[2])));
+		glm::vec3 extent = absolute * localExtent;
+
+		return { center - extent, center + extent };
+	}
+
+	bool Aabb::Contains(const Aabb& other) const
+	{
+		return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+			&& other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+	}
+
+	bool Aabb::Overlaps(const Aabb& other) const
+	{
+		return min.x <= other.max.x && other.min.x <= max.x
+			&& min.y <= other.max.y && other.min.y <= max.y
+			&& min.z <= other.max.z && other.min.z <= max.z;
+	}
+
+	float Aabb::Area() const
+	{
+		glm::vec3 size = max - min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	bool Aabb::RayIntersect(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) const
+	{
+		glm::vec3 t0 = (min - origin) * inverseDirection;
+		glm::vec3 t1 = (max - origin) * inverseDirection;
+		glm::vec3 entries = glm::min(t0, t1);
+		glm::vec3 exits = glm::max(t0, t1);
+
+		float enter = std::max({ entries.x, entries.y, entries.z, 0.0f });
+		float exit = std::min({ exits.x, exits.y, exits.z, maxDistance });
+
+		if (enter > exit) return false;
+
+		distance = enter;
+		return true;
+	}
+
+	int AabbTree::AllocateNode()
+	{
+		if (mFreeList == Null)
+		{
+			mNodes.emplace_back();
+			return static_cast<int>(mNodes.size() - 1);
+		}
+
+		int index = mFreeList;
+		mFreeList = mNodes[index].parent;
+		--mFreeCount;
+
+		mNodes[index] = Node{};
+		return index;
+	}
+
+	void AabbTree::FreeNode(int index)
+	{
+		mNodes[index].parent = mFreeList;
+		mNodes[index].height = -1;
+		mFreeList = index;
+		++mFreeCount;
+	}
+
+	int AabbTree::Insert(const Aabb& box, std::uint32_t userData)
+	{
+		int proxy = AllocateNode();
+		mNodes[proxy].box = box.Expanded(mMargin);
+		mNodes[proxy].userData = userData;
+		mNodes[proxy].height = 0;
+
+		InsertLeaf(proxy);
+		++mProxyCount;
+
+		return proxy;
+	}
+
+	void AabbTree::Remove(int proxy)
+	{
+		assert(mNodes[proxy].IsLeaf() && mNodes[proxy].height == 0);
+
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+		--mProxyCount;
+	}
+
+	bool AabbTree::Move(int proxy, const Aabb& box)
+	{
+		if (mNodes[proxy].box.Contains(box))
+		{
+			// Keep a shrinking object from holding on to a box far larger than it is
+			Aabb largest = box.Expanded(mMargin * 4.0f);
+			if (largest.Contains(mNodes[proxy].box)) return false;
+		}
+
+		RemoveLeaf(proxy);
+		mNodes[proxy].box = box.Expanded(mMargin);
+		InsertLeaf(proxy);
+
+		return true;
+	}
+
+	void AabbTree::Clear()
+	{
+		mNodes.clear();
+		mRoot = Null;
+		mFreeList = Null;
+		mFreeCount = 0;
+		mProxyCount = 0;
+	}
+
+	void AabbTree::InsertLeaf(int leaf)
+	{
+		if (mRoot == Null)
+		{
+			mRoot = leaf;
+			mNodes[leaf].parent = Null;
+			return;
+		}
+
+		// Descend towards the cheapest sibling. Making a node the sibling costs the area of the new parent,
+		// every ancestor on the way grows by the same amount as its box grows
+		Aabb leafBox = mNodes[leaf].box;
+		int index = mRoot;
+
+		while (!mNodes[index].IsLeaf())
+		{
+			const Node& node = mNodes[index];
+
+			float area = node.box.Area();
+			float combinedArea = node.box.Union(leafBox).Area();
+
+			float cost = 2.0f * combinedArea;
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto childCost = [&](int child)
+			{
+				const Aabb& childBox = mNodes[child].box;
+				float unionArea = childBox.Union(leafBox).Area();
+
+				if (mNodes[child].IsLeaf())
+					return unionArea + inheritanceCost;
+
+				return unionArea - childBox.Area() + inheritanceCost;
+			};
+
+			float cost1 = childCost(node.child1);
+			float cost2 = childCost(node.child2);
+
+			if (cost < cost1 && cost < cost2) break;
+
+			index = cost1 < cost2 ? node.child1 : node.child2;
+		}
+
+		int sibling = index;
+		int oldParent = mNodes[sibling].parent;
+		int newParent = AllocateNode();
+
+		mNodes[newParent].parent = oldParent;
+		mNodes[newParent].box = leafBox.Union(mNodes[sibling].box);
+		mNodes[newParent].height = mNodes[sibling].height + 1;
+		mNodes[newParent].leaves = mNodes[sibling].leaves + 1;
+		mNodes[newParent].child1 = sibling;
+		mNodes[newParent].child2 = leaf;
+		mNodes[sibling].parent = newParent;
+		mNodes[leaf].parent = newParent;
+
+		if (oldParent == Null)
+		{
+			mRoot = newParent;
+		}
+		else
+		{
+			if (mNodes[oldParent].child1 == sibling)
+				mNodes[oldParent].child1 = newParent;
+			else
+				mNodes[oldParent].child2 = newParent;
+		}
+
+		Refit(mNodes[leaf].parent);
+	}
+
+	void AabbTree::RemoveLeaf(int leaf)
+	{
+		if (leaf == mRoot)
+		{
+			mRoot = Null;
+			return;
+		}
+
+		int parent = mNodes[leaf].parent;
+		int grandParent = mNodes[parent].parent;
+		int sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+		// The sibling takes the parent's place
+		if (grandParent == Null)
+		{
+			mRoot = sibling;
+			mNodes[sibling].parent = Null;
+		}
+		else
+		{
+			if (mNodes[grandParent].child1 == parent)
+				mNodes[grandParent].child1 = sibling;
+			else
+				mNodes[grandParent].child2 = sibling;
+
+			mNodes[sibling].parent = grandParent;
+			Refit(grandParent);
+		}
+
+		FreeNode(parent);
+	}
+
+	void AabbTree::Refit(int index)
+	{
+		while (index != Null)
+		{
+			index = Balance(index);
+
+			Node& node = mNodes[index];
+			const Node& child1 = mNodes[node.child1];
+			const Node& child2 = mNodes[node.child2];
+
+			node.height = 1 + std::max(child1.height, child2.height);
+			node.leaves = child1.leaves + child2.leaves;
+			node.box = child1.box.Union(child2.box);
+
+			index = node.parent;
+		}
+	}
+
+	int AabbTree::Balance(int a)
+	{
+		Node& nodeA = mNodes[a];
+		if (nodeA.IsLeaf() || nodeA.height < 2) return a;
+
+		int b = nodeA.child1;
+		int c = nodeA.child2;
+		int balance = mNodes[c].height - mNodes[b].height;
+
+		if (balance >= -1 && balance <= 1) return a;
+
+		// The deeper child moves up into a's place, a takes its shallower grandchild
+		int up = balance > 1 ? c : b;
+		int stay = balance > 1 ? b : c;
+
+		Node& nodeUp = mNodes[up];
+		int f = nodeUp.child1;
+		int g = nodeUp.child2;
+
+		nodeUp.child1 = a;
+		nodeUp.parent = nodeA.parent;
+		nodeA.parent = up;
+
+		if (nodeUp.parent == Null)
+			mRoot = up;
+		else if (mNodes[nodeUp.parent].child1 == a)
+			mNodes[nodeUp.parent].child1 = up;
+		else
+			mNodes[nodeUp.parent].child2 = up;
+
+		// The taller grandchild stays with the node that moved up
+		if (mNodes[g].height > mNodes[f].height)
+			std::swap(f, g);
+
+		nodeUp.child2 = f;
+
+		if (balance > 1)
+			nodeA.child2 = g;
+		else
+			nodeA.child1 = g;
+
+		mNodes[g].parent = a;
+
+		nodeA.box = mNodes[stay].box.Union(mNodes[g].box);
+		nodeA.height = 1 + std::max(mNodes[stay].height, mNodes[g].height);
+		nodeA.leaves = mNodes[stay].leaves + mNodes[g].leaves;
+		nodeUp.box = nodeA.box.Union(mNodes[f].box);
+		nodeUp.height = 1 + std::max(nodeA.height, mNodes[f].height);
+		nodeUp.leaves = nodeA.leaves + mNodes[f].leaves;
+
+		return up;
+	}
+}
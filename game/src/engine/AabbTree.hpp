@@ -0,0 +1,287 @@
+#pragma once
+
+#include "FrustumCulling.hpp"
+#include "mesh.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace FoxEngine
+{
+	struct Aabb final
+	{
+		glm::vec3 min{};
+		glm::vec3 max{};
+
+		// Arvo: the world box around a transformed local box
+		static Aabb FromBounds(const Mesh::Bounds& bounds, const glm::mat4& world);
+
+		Aabb Union(const Aabb& other) const { return { glm::min(min, other.min), glm::max(max, other.max) }; }
+		Aabb Expanded(float margin) const { return { min - glm::vec3(margin), max + glm::vec3(margin) }; }
+
+		bool Contains(const Aabb& other) const;
+		bool Overlaps(const Aabb& other) const;
+
+		// Half the surface area, only used to compare insertion costs
+		float Area() const;
+
+		// Slab test, inverseDirection may hold infinities for axis aligned rays. Writes the entry distance on a hit
+		bool RayIntersect(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) const;
+	};
+
+	// Dynamic bounding volume hierarchy, boxes can be added, removed and moved one at a time
+	//
+	// Leaves hold a box enlarged by a margin, so small movement doesn't touch the tree at all. New leaves go next to
+	// the sibling that grows the tree's total area the least and every change walks back to the root with rotations
+	// that keep it balanced, so queries stay logarithmic no matter the insertion order
+	class AabbTree final
+	{
+	public:
+		static constexpr int Null = -1;
+
+		explicit AabbTree(float margin = 0.1f) : mMargin(margin) {}
+
+		// Returns the proxy used to move or remove the box later
+		int Insert(const Aabb& box, std::uint32_t userData);
+		void Remove(int proxy);
+
+		// Returns true if the leaf had to be reinserted, false if the box still fits the enlarged one
+		bool Move(int proxy, const Aabb& box);
+
+		std::uint32_t UserData(int proxy) const { return mNodes[proxy].userData; }
+		const Aabb& FatBox(int proxy) const { return mNodes[proxy].box; }
+
+		// Callback receives the user data of every leaf whose box intersects the frustum.
+		// Subtrees fully inside are reported without testing the leaves. Returns how many leaves were rejected,
+		// counted from the subtrees that were skipped
+		template<class F>
+		std::size_t QueryFrustum(const Frustum& frustum, F&& callback) const;
+
+		// Callback receives the user data of every leaf whose box overlaps the given one
+		template<class F>
+		void QueryOverlap(const Aabb& box, F&& callback) const;
+
+		// Callback receives the user data and the entry distance of every leaf the ray enters before maxDistance,
+		// nearest subtrees first. It returns the new maximum distance, return the hit distance to find the closest
+		// hit, maxDistance to keep all hits or zero to stop
+		template<class F>
+		void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, F&& callback) const;
+
+		void Clear();
+
+		std::size_t ProxyCount() const noexcept { return mProxyCount; }
+		std::size_t NodeCount() const noexcept { return mNodes.size() - mFreeCount; }
+		int Height() const { return mRoot == Null ? 0 : mNodes[mRoot].height; }
+	private:
+		struct Node final
+		{
+			Aabb box;
+			std::uint32_t userData = 0;
+			int parent = Null; // Next free node while on the free list
+			int child1 = Null;
+			int child2 = Null;
+			int height = -1; // 0 for leaves, -1 while free
+			std::uint32_t leaves = 1; // In this subtree
+
+			bool IsLeaf() const { return child1 == Null; }
+		};
+
+		int AllocateNode();
+		void FreeNode(int node);
+
+		void InsertLeaf(int leaf);
+		void RemoveLeaf(int leaf);
+
+		// Refits boxes and heights from index up to the root, rotating where the children are uneven
+		void Refit(int index);
+
+		// Rotates a grandchild up if one side of index is two or more levels deeper, returns the new subtree root
+		int Balance(int index);
+
+		template<class F>
+		void ReportSubtree(int index, F& callback, std::vector<int>& stack) const;
+	private:
+		std::vector<Node> mNodes;
+		int mRoot = Null;
+		int mFreeList = Null;
+		std::size_t mFreeCount = 0;
+		std::size_t mProxyCount = 0;
+		float mMargin;
+	};
+
+	template<class F>
+	void AabbTree::ReportSubtree(int index, F& callback, std::vector<int>& stack) const
+	{
+		std::size_t base = stack.size();
+		stack.push_back(index);
+
+		while (stack.size() > base)
+		{
+			const Node& node = mNodes[stack.back()];
+			stack.pop_back();
+
+			if (node.IsLeaf())
+			{
+				callback(node.userData);
+				continue;
+			}
+
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+	template<class F>
+	std::size_t AabbTree::QueryFrustum(const Frustum& frustum, F&& callback) const
+	{
+		if (mRoot == Null) return 0;
+
+		std::size_t rejected = 0;
+
+		std::vector<int> stack;
+		stack.reserve(64);
+		stack.push_back(mRoot);
+
+		while (!stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+
+			const Node& node = mNodes[index];
+			glm::vec3 center = (node.box.min + node.box.max) * 0.5f;
+			glm::vec3 extent = (node.box.max - node.box.min) * 0.5f;
+
+			bool outside = false;
+			bool intersects = false;
+
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+				float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+
+				if (distance + radius < 0.0f)
+				{
+					outside = true;
+					break;
+				}
+
+				if (distance - radius < 0.0f)
+					intersects = true;
+			}
+
+			if (outside)
+			{
+				rejected += node.leaves;
+				continue;
+			}
+
+			if (!intersects || node.IsLeaf())
+			{
+				ReportSubtree(index, callback, stack);
+				continue;
+			}
+
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+
+		return rejected;
+	}
+
+	template<class F>
+	void AabbTree::QueryOverlap(const Aabb& box, F&& callback) const
+	{
+		if (mRoot == Null) return;
+
+		std::vector<int> stack;
+		stack.reserve(64);
+		stack.push_back(mRoot);
+
+		while (!stack.empty())
+		{
+			const Node& node = mNodes[stack.back()];
+			stack.pop_back();
+
+			if (!node.box.Overlaps(box)) continue;
+
+			if (node.IsLeaf())
+			{
+				callback(node.userData);
+				continue;
+			}
+
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+	template<class F>
+	void AabbTree::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, F&& callback) const
+	{
+		if (mRoot == Null) return;
+
+		glm::vec3 inverseDirection = 1.0f / direction;
+
+		struct Entry final
+		{
+			int index;
+			float distance;
+		};
+
+		std::vector<Entry> stack;
+		stack.reserve(64);
+
+		float distance;
+		if (!mNodes[mRoot].box.RayIntersect(origin, inverseDirection, maxDistance, distance)) return;
+		stack.push_back({ mRoot, distance });
+
+		while (!stack.empty())
+		{
+			Entry entry = stack.back();
+			stack.pop_back();
+
+			// A closer hit was found since this was pushed
+			if (entry.distance > maxDistance) continue;
+
+			const Node& node = mNodes[entry.index];
+
+			if (node.IsLeaf())
+			{
+				maxDistance = callback(node.userData, entry.distance);
+				if (maxDistance <= 0.0f) return;
+				continue;
+			}
+
+			float distance1, distance2;
+			bool hit1 = mNodes[node.child1].box.RayIntersect(origin, inverseDirection, maxDistance, distance1);
+			bool hit2 = mNodes[node.child2].box.RayIntersect(origin, inverseDirection, maxDistance, distance2);
+
+			// The nearer child is pushed last so it is visited first
+			if (hit1 && hit2)
+			{
+				if (distance1 < distance2)
+				{
+					stack.push_back({ node.child2, distance2 });
+					stack.push_back({ node.child1, distance1 });
+				}
+				else
+				{
+					stack.push_back({ node.child1, distance1 });
+					stack.push_back({ node.child2, distance2 });
+				}
+			}
+			else if (hit1)
+			{
+				stack.push_back({ node.child1, distance1 });
+			}
+			else if (hit2)
+			{
+				stack.push_back({ node.child2, distance2 });
+			}
+		}
+	}
+}
@@ -0,0 +1,161 @@
+#include "AsyncReadback.hpp"
+
+#include "log.hpp"
+
+#include <glad/gl.h>
+
+#include <string>
+#include <vector>
+
+namespace FoxEngine
+{
+	class AsyncReadbackOGL33 final : public AsyncReadback
+	{
+	public:
+		AsyncReadbackOGL33(const AsyncReadback::CreateInfo& info)
+		{
+			mSlots.resize(info.slots ? info.slots : 1);
+
+			for (std::size_t i = 0; i < mSlots.size(); ++i)
+			{
+				glGenBuffers(1, &mSlots[i].buffer);
+
+				if (GLAD_GL_KHR_debug && !info.debugName.empty())
+				{
+					// Labels need the object to exist, which happens on the first bind
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, mSlots[i].buffer);
+
+					std::string label = std::string(info.debugName) + " " + std::to_string(i);
+					glObjectLabel(GL_BUFFER, mSlots[i].buffer, static_cast<int>(label.size()), label.data());
+				}
+			}
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+
+		virtual ~AsyncReadbackOGL33() noexcept
+		{
+			for (Slot& slot : mSlots)
+			{
+				if (slot.fence)
+					glDeleteSync(slot.fence);
+
+				if (slot.buffer)
+					glDeleteBuffers(1, &slot.buffer);
+			}
+		}
+
+		std::uint64_t Read(int x, int y, int width, int height) override
+		{
+			Slot& slot = mSlots[mHead];
+
+			if (slot.fence)
+			{
+				++mStats.dropped;
+				return 0;
+			}
+
+			std::size_t size = static_cast<std::size_t>(width) * height * 4;
+
+			// Pack buffers stay bound only for the copy, other reads expect client memory
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+			if (slot.capacity < size)
+			{
+				glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+				slot.capacity = size;
+			}
+
+			glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			slot.width = width;
+			slot.height = height;
+			slot.id = ++mStats.issued;
+
+			mHead = (mHead + 1) % mSlots.size();
+			++mPending;
+
+			return slot.id;
+		}
+
+		void Poll(const Callback& callback) override
+		{
+			while (mPending)
+			{
+				Slot& slot = mSlots[mTail];
+
+				// Zero timeout only queries, the flush makes sure the fence reaches the gpu at all
+				unsigned int status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+				if (status == GL_WAIT_FAILED)
+				{
+					// The fence will never signal, the copy is given up so the slot doesn't stay taken
+					Log::Error("Async readback {} failed to wait on its fence, gl error {}", slot.id, glGetError());
+
+					glDeleteSync(slot.fence);
+					slot.fence = nullptr;
+
+					mTail = (mTail + 1) % mSlots.size();
+					--mPending;
+					++mStats.failed;
+					continue;
+				}
+
+				if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+					break;
+
+				glDeleteSync(slot.fence);
+				slot.fence = nullptr;
+
+				std::size_t size = static_cast<std::size_t>(slot.width) * slot.height * 4;
+
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+				if (const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT))
+				{
+					callback({
+						.id = slot.id,
+						.width = slot.width,
+						.height = slot.height,
+						.pixels = { static_cast<const unsigned char*>(mapped), size }
+					});
+
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				}
+
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+				mTail = (mTail + 1) % mSlots.size();
+				--mPending;
+				++mStats.completed;
+			}
+		}
+
+		unsigned int Pending() const noexcept override { return mPending; }
+
+		const Stats& GetStats() const noexcept override { return mStats; }
+	private:
+		struct Slot final
+		{
+			unsigned int buffer = 0;
+			std::size_t capacity = 0;
+			GLsync fence = nullptr; // Set while the copy is in flight
+			int width = 0;
+			int height = 0;
+			std::uint64_t id = 0;
+		};
+
+		std::vector<Slot> mSlots;
+		std::size_t mHead = 0; // Next slot to read into
+		std::size_t mTail = 0; // Oldest slot in flight
+		unsigned int mPending = 0;
+		Stats mStats;
+	};
+
+	std::unique_ptr<AsyncReadback> AsyncReadback::Create(const AsyncReadback::CreateInfo& info)
+	{
+		return std::make_unique<AsyncReadbackOGL33>(info);
+	}
+}
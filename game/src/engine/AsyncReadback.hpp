@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace FoxEngine
+{
+	// Copies pixels from the gpu without waiting for it
+	//
+	// Read queues a copy of the bound read framebuffer into a pixel pack buffer and places a fence behind it.
+	// Poll hands out copies whose fence has signalled, oldest first, usually a frame or two after the Read.
+	// The ring holds a fixed number of copies in flight, Read fails while all of them are still pending
+	class AsyncReadback
+	{
+	public:
+		struct CreateInfo final
+		{
+			unsigned int slots = 3;
+			std::string_view debugName;
+		};
+
+		struct Result final
+		{
+			std::uint64_t id = 0; // Returned by the Read that queued it
+			int width = 0;
+			int height = 0;
+			std::span<const unsigned char> pixels; // Rgba8 rows from the bottom up, valid during the callback
+		};
+
+		struct Stats final
+		{
+			std::uint64_t issued = 0;
+			std::uint64_t completed = 0;
+			std::uint64_t dropped = 0; // Reads refused because the ring was full
+			std::uint64_t failed = 0; // Copies given up because waiting on their fence failed
+		};
+
+		using Callback = std::function<void(const Result&)>;
+
+		static std::unique_ptr<AsyncReadback> Create(const CreateInfo& info);
+	public:
+		constexpr AsyncReadback() noexcept = default;
+		virtual ~AsyncReadback() noexcept = default;
+
+		AsyncReadback(const AsyncReadback&) = delete;
+		AsyncReadback& operator=(const AsyncReadback&) = delete;
+		AsyncReadback(AsyncReadback&&) noexcept = delete;
+		AsyncReadback& operator=(AsyncReadback&&) noexcept = delete;
+
+		// Rectangle of the current read framebuffer, returns 0 when no slot is free
+		virtual std::uint64_t Read(int x, int y, int width, int height) = 0;
+
+		// Never blocks, call once per frame
+		virtual void Poll(const Callback& callback) = 0;
+
+		virtual unsigned int Pending() const noexcept = 0;
+
+		virtual const Stats& GetStats() const noexcept = 0;
+	};
+}
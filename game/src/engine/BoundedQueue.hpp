@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace FoxEngine
+{
+	// Multi producer queue with a fixed capacity, producers block while it is full
+	// The consumer never blocks, it is expected to poll once per frame
+	template<class T>
+	class BoundedQueue final
+	{
+	public:
+		explicit BoundedQueue(std::size_t capacity) : mCapacity(capacity) {}
+
+		BoundedQueue(const BoundedQueue&) = delete;
+		BoundedQueue& operator=(const BoundedQueue&) = delete;
+		BoundedQueue(BoundedQueue&&) noexcept = delete;
+		BoundedQueue& operator=(BoundedQueue&&) noexcept = delete;
+
+		// Returns false if the queue was closed, the value is discarded in that case
+		bool Push(T value)
+		{
+			std::unique_lock lock{ mMutex };
+			mNotFull.wait(lock, [this] { return mClosed || mItems.size() < mCapacity; });
+
+			if (mClosed) return false;
+
+			mItems.push_back(std::move(value));
+			return true;
+		}
+
+		bool TryPop(T& value)
+		{
+			{
+				std::lock_guard lock{ mMutex };
+
+				if (mItems.empty()) return false;
+
+				value = std::move(mItems.front());
+				mItems.pop_front();
+			}
+
+			mNotFull.notify_one();
+			return true;
+		}
+
+		// Wakes up every blocked producer, any further pushes fail
+		void Close()
+		{
+			{
+				std::lock_guard lock{ mMutex };
+				mClosed = true;
+				mItems.clear();
+			}
+
+			mNotFull.notify_all();
+		}
+
+		std::size_t Size()
+		{
+			std::lock_guard lock{ mMutex };
+			return mItems.size();
+		}
+	private:
+		std::mutex mMutex;
+		std::condition_variable mNotFull;
+		std::deque<T> mItems;
+		std::size_t mCapacity;
+		bool mClosed = false;
+	};
+}
@@ -0,0 +1,117 @@
+#include "Buffer.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace FoxEngine
+{
+	static unsigned int BufferTypeToTarget(Buffer::Type type)
+	{
+		using enum Buffer::Type;
+
+		switch (type)
+		{
+		case Uniform:
+			return GL_UNIFORM_BUFFER;
+		case Vertex:
+			return GL_ARRAY_BUFFER;
+		}
+
+		throw std::runtime_error("Invalid buffer type");
+	}
+
+	static unsigned int BufferUsageToUsage(Buffer::Usage usage)
+	{
+		using enum Buffer::Usage;
+
+		switch (usage)
+		{
+		case Static:
+			return GL_STATIC_DRAW;
+		case Dynamic:
+			return GL_DYNAMIC_DRAW;
+		case Stream:
+			return GL_STREAM_DRAW;
+		}
+
+		throw std::runtime_error("Invalid buffer usage");
+	}
+
+	class BufferOGL33 final : public Buffer
+	{
+	public:
+		BufferOGL33(const Buffer::CreateInfo& info)
+		{
+			mTarget = BufferTypeToTarget(info.type);
+			mUsage = BufferUsageToUsage(info.usage);
+			mSize = info.size;
+
+			glGenBuffers(1, &mHandle);
+			glBindBuffer(mTarget, mHandle);
+
+			if (GLAD_GL_KHR_debug && !info.debugName.empty())
+				glObjectLabel(GL_BUFFER, mHandle, info.debugName.size(), info.debugName.data());
+
+			glBufferData(mTarget, mSize, info.data, mUsage);
+		}
+
+		virtual ~BufferOGL33() noexcept
+		{
+			if (mHandle)
+				glDeleteBuffers(1, &mHandle);
+		}
+
+		void Upload(const void* data, std::size_t size, std::size_t offset) override
+		{
+			glBindBuffer(mTarget, mHandle);
+
+			if (offset == 0)
+			{
+				// Orphan the old storage, grows the buffer if needed
+				mSize = std::max(mSize, size);
+				glBufferData(mTarget, mSize, size == mSize ? data : nullptr, mUsage);
+
+				if (size == mSize) return;
+			}
+
+			glBufferSubData(mTarget, offset, size, data);
+		}
+
+		void BindBase(unsigned int binding) override
+		{
+			glBindBufferBase(mTarget, binding, mHandle);
+		}
+
+		void BindRange(unsigned int binding, std::size_t offset, std::size_t size) override
+		{
+			glBindBufferRange(mTarget, binding, mHandle, offset, size);
+		}
+
+		std::size_t Size() const noexcept override { return mSize; }
+		unsigned int Handle() const noexcept override { return mHandle; }
+	private:
+		unsigned int mHandle = 0;
+		unsigned int mTarget = 0;
+		unsigned int mUsage = 0;
+		std::size_t mSize = 0;
+	};
+
+	std::unique_ptr<Buffer> Buffer::Create(const Buffer::CreateInfo& info)
+	{
+		return std::make_unique<BufferOGL33>(info);
+	}
+
+	std::size_t Buffer::UniformOffsetAlignment()
+	{
+		static const std::size_t alignment = []
+			{
+				int value = 0;
+				glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+				return value > 0 ? static_cast<std::size_t>(value) : std::size_t(256);
+			}();
+
+		return alignment;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace FoxEngine
+{
+	class Buffer
+	{
+	public:
+		enum struct Type
+		{
+			Uniform, Vertex
+		};
+
+		// Hint for how often the contents are replaced
+		enum struct Usage
+		{
+			Static, Dynamic, Stream
+		};
+
+		struct CreateInfo final
+		{
+			Type type = Type::Uniform;
+			Usage usage = Usage::Dynamic;
+			std::size_t size = 0;
+			const void* data = nullptr; // Contents are undefined when null
+			std::string_view debugName;
+		};
+
+		static std::unique_ptr<Buffer> Create(const CreateInfo& info);
+
+		// Offsets passed to BindRange must be a multiple of this
+		static std::size_t UniformOffsetAlignment();
+	public:
+		constexpr Buffer() noexcept = default;
+		virtual ~Buffer() noexcept = default;
+
+		Buffer(const Buffer&) = delete;
+		Buffer& operator=(const Buffer&) = delete;
+		Buffer(Buffer&&) noexcept = delete;
+		Buffer& operator=(Buffer&&) noexcept = delete;
+
+		// Uploading at offset zero replaces the whole storage and grows it if needed, the rest of the contents become undefined.
+		// The driver hands out fresh memory rather than waiting on draws still reading the old contents
+		virtual void Upload(const void* data, std::size_t size, std::size_t offset = 0) = 0;
+
+		// Uniform buffers only, binds to an indexed binding point
+		virtual void BindBase(unsigned int binding) = 0;
+		virtual void BindRange(unsigned int binding, std::size_t offset, std::size_t size) = 0;
+
+		virtual std::size_t Size() const noexcept = 0;
+		virtual unsigned int Handle() const noexcept = 0;
+	};
+}
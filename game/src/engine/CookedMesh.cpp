@@ -0,0 +1,125 @@
+#include "CookedMesh.hpp"
+
+#include "log.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace FoxEngine::CookedMesh
+{
+	static void StatSource(std::string_view resource, std::uint64_t& size, std::int64_t& time)
+	{
+		std::error_code ec;
+		std::filesystem::path path{ resource };
+
+		size = 0;
+		time = 0;
+
+		auto fileSize = std::filesystem::file_size(path, ec);
+		if (ec) return;
+
+		auto fileTime = std::filesystem::last_write_time(path, ec);
+		if (ec) return;
+
+		size = fileSize;
+		time = fileTime.time_since_epoch().count();
+	}
+
+	std::string PathFor(std::string_view resource)
+	{
+		return std::string(resource) + ".femesh";
+	}
+
+	std::optional<View> Load(std::string_view resource)
+	{
+		std::string path = PathFor(resource);
+
+		if (!std::filesystem::exists(path))
+			return std::nullopt;
+
+		View view;
+
+		try
+		{
+			view.blob = Blob::MapFile(path);
+		}
+		catch (const Exception::FileRead&)
+		{
+			return std::nullopt;
+		}
+
+		if (view.blob.size() < sizeof(Header))
+			return std::nullopt;
+
+		const Header& header = *reinterpret_cast<const Header*>(view.blob.data());
+
+		if (header.magic != Magic || header.version != Version)
+			return std::nullopt;
+
+		if (header.vertexStride != sizeof(Mesh::Vertex) || header.indexStride != sizeof(Mesh::Index))
+			return std::nullopt;
+
+		// Counts come from the file, bound each one by what is left before multiplying so nothing can wrap
+		std::uint64_t payload = view.blob.size() - sizeof(Header);
+
+		if (header.vertexCount > payload / sizeof(Mesh::Vertex))
+			return std::nullopt;
+
+		payload -= header.vertexCount * sizeof(Mesh::Vertex);
+
+		if (header.indexCount != payload / sizeof(Mesh::Index) || payload % sizeof(Mesh::Index) != 0)
+			return std::nullopt;
+
+		// A missing source is fine, that is what a shipped build looks like
+		std::uint64_t sourceSize;
+		std::int64_t sourceTime;
+		StatSource(resource, sourceSize, sourceTime);
+
+		if (sourceSize != 0 && (sourceSize != header.sourceSize || sourceTime != header.sourceTime))
+		{
+			Log::Info("Cooked mesh is stale: {}", path);
+			return std::nullopt;
+		}
+
+		const std::byte* vertices = view.blob.data() + sizeof(Header);
+		const std::byte* indices = vertices + header.vertexCount * sizeof(Mesh::Vertex);
+
+		view.vertices = { reinterpret_cast<const Mesh::Vertex*>(vertices), static_cast<std::size_t>(header.vertexCount) };
+		view.indices = { reinterpret_cast<const Mesh::Index*>(indices), static_cast<std::size_t>(header.indexCount) };
+
+		return view;
+	}
+
+	void Write(std::string_view resource, std::span<const Mesh::Vertex> vertices, std::span<const Mesh::Index> indices)
+	{
+		std::string path = PathFor(resource);
+		std::string tempPath = path + ".tmp";
+
+		Header header;
+		header.vertexCount = vertices.size();
+		header.indexCount = indices.size();
+		StatSource(resource, header.sourceSize, header.sourceTime);
+
+		{
+			std::ofstream out{ tempPath, std::ios::out | std::ios::binary | std::ios::trunc };
+
+			if (!out) throw Exception::FileRead{ "Failed to open cooked mesh for writing" };
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(vertices.data()), vertices.size_bytes());
+			out.write(reinterpret_cast<const char*>(indices.data()), indices.size_bytes());
+
+			if (!out) throw Exception::FileRead{ "Failed to write cooked mesh" };
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tempPath, path, ec);
+
+		if (ec)
+		{
+			std::filesystem::remove(tempPath, ec);
+			throw Exception::FileRead{ "Failed to replace cooked mesh" };
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "mesh.hpp"
+#include "blob.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <optional>
+
+// Cooked meshes are a direct dump of the vertex and index data Mesh::Create consumes,
+// they are written next to the source file as "<resource>.femesh"
+//
+// Layout: Header | Vertex[vertexCount] | Index[indexCount]
+
+namespace FoxEngine::CookedMesh
+{
+	inline constexpr std::uint32_t Magic = 0x534D4546; // "FEMS"
+	inline constexpr std::uint32_t Version = 1;
+
+	struct Header final
+	{
+		std::uint32_t magic = Magic;
+		std::uint32_t version = Version;
+		std::uint32_t vertexStride = sizeof(Mesh::Vertex);
+		std::uint32_t indexStride = sizeof(Mesh::Index);
+		std::uint64_t vertexCount = 0;
+		std::uint64_t indexCount = 0;
+
+		// Used to detect stale files, both are zero if the source didn't exist when cooking
+		std::uint64_t sourceSize = 0;
+		std::int64_t sourceTime = 0;
+	};
+
+	static_assert(sizeof(Header) % alignof(Mesh::Vertex) == 0, "Vertex data must stay aligned after the header");
+	static_assert(sizeof(Mesh::Vertex) % alignof(Mesh::Index) == 0, "Index data must stay aligned after the vertices");
+
+	// Keeps the mapping alive for as long as the spans are used
+	struct View final
+	{
+		Blob blob;
+		std::span<const Mesh::Vertex> vertices;
+		std::span<const Mesh::Index> indices;
+	};
+
+	std::string PathFor(std::string_view resource);
+
+	// Returns nothing if the cooked file is missing, malformed or older than its source
+	std::optional<View> Load(std::string_view resource);
+
+	// Throws Exception::FileRead on failure, the file is replaced atomically
+	void Write(std::string_view resource, std::span<const Mesh::Vertex> vertices, std::span<const Mesh::Index> indices);
+}
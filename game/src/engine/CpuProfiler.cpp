@@ -0,0 +1,200 @@
+#include "CpuProfiler.hpp"
+
+#include "log.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace FoxEngine
+{
+	// Names are literals from the source, quotes and backslashes are the only things likely to need escaping
+	static void WriteJsonString(std::ostream& out, std::string_view string)
+	{
+		out << '"';
+
+		for (char c : string)
+		{
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20)
+				out << ' ';
+			else
+				out << c;
+		}
+
+		out << '"';
+	}
+
+	CpuProfiler& CpuProfiler::Get()
+	{
+		static CpuProfiler profiler;
+		return profiler;
+	}
+
+	CpuProfiler::CpuProfiler()
+		: mEpoch(std::chrono::steady_clock::now())
+	{
+	}
+
+	CpuProfiler::ThreadBuffer& CpuProfiler::Local()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+
+		if (!buffer)
+		{
+			// Owned by the profiler so the events of a thread that has exited are still exported
+			std::lock_guard lock{ mThreadsMutex };
+			buffer = mThreads.emplace_back(std::make_unique<ThreadBuffer>()).get();
+			buffer->id = static_cast<std::uint32_t>(mThreads.size());
+			buffer->name = "Thread " + std::to_string(buffer->id);
+		}
+
+		return *buffer;
+	}
+
+	void CpuProfiler::SetThreadName(std::string_view name)
+	{
+		ThreadBuffer& buffer = Local();
+
+		std::lock_guard lock{ mThreadsMutex };
+		buffer.name = name;
+	}
+
+	void CpuProfiler::Begin(const char* name)
+	{
+		ThreadBuffer& buffer = Local();
+		std::uint32_t depth = buffer.depth++;
+
+		if (depth >= MaxDepth)
+			return;
+
+		buffer.names[depth] = name;
+		buffer.starts[depth] = Now();
+	}
+
+	void CpuProfiler::End()
+	{
+		ThreadBuffer& buffer = Local();
+
+		if (!buffer.depth)
+			return;
+
+		std::uint32_t depth = --buffer.depth;
+
+		if (depth >= MaxDepth)
+			return;
+
+		// Only this thread writes. The fence pairs with the one in Snapshot: a copy that sees any of these stores
+		// also sees the count from before them, which marks the slot as being overwritten. The release publishes
+		// the event
+		std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+		EventSlot& slot = buffer.events[index % EventsPerThread];
+
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(buffer.names[depth], std::memory_order_relaxed);
+		slot.start.store(buffer.starts[depth], std::memory_order_relaxed);
+		slot.end.store(Now(), std::memory_order_relaxed);
+		slot.depth.store(depth, std::memory_order_relaxed);
+
+		buffer.written.store(index + 1, std::memory_order_release);
+	}
+
+	std::vector<CpuProfiler::ThreadEvents> CpuProfiler::Snapshot(std::int64_t since) const
+	{
+		std::lock_guard lock{ mThreadsMutex };
+
+		std::vector<ThreadEvents> threads;
+		threads.reserve(mThreads.size());
+
+		for (const std::unique_ptr<ThreadBuffer>& buffer : mThreads)
+		{
+			ThreadEvents& thread = threads.emplace_back();
+			thread.name = buffer->name;
+			thread.id = buffer->id;
+
+			std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+			std::uint64_t oldest = written > EventsPerThread ? written - EventsPerThread : 0;
+
+			// Scopes are written as they close so end times only grow, walk back until they are too old
+			std::uint64_t first = written;
+
+			while (first > oldest && buffer->events[(first - 1) % EventsPerThread].end.load(std::memory_order_relaxed) >= since)
+				--first;
+
+			thread.events.reserve(written - first);
+
+			for (std::uint64_t i = first; i < written; ++i)
+			{
+				const EventSlot& slot = buffer->events[i % EventsPerThread];
+
+				thread.events.push_back({
+					.name = slot.name.load(std::memory_order_relaxed),
+					.start = slot.start.load(std::memory_order_relaxed),
+					.end = slot.end.load(std::memory_order_relaxed),
+					.depth = slot.depth.load(std::memory_order_relaxed)
+				});
+			}
+
+			// The owner kept writing during the copy, anything it may have lapped is unreliable. That includes the
+			// slot of the event after the last published one, which may be half written
+			std::atomic_thread_fence(std::memory_order_acquire);
+			std::uint64_t after = buffer->written.load(std::memory_order_relaxed);
+			std::uint64_t valid = after + 1 > EventsPerThread ? after + 1 - EventsPerThread : 0;
+
+			if (valid > first)
+				thread.events.erase(thread.events.begin(), thread.events.begin() + static_cast<std::ptrdiff_t>(std::min(valid - first, written - first)));
+		}
+
+		return threads;
+	}
+
+	bool CpuProfiler::ExportChromeTrace(const std::string& path) const
+	{
+		std::vector<ThreadEvents> threads = Snapshot();
+
+		std::ofstream out{ path, std::ios::out | std::ios::trunc };
+
+		if (!out)
+		{
+			Log::Warn("Failed to write cpu trace: {}", path);
+			return false;
+		}
+
+		// Timestamps are in microseconds, complete events ("X") carry their own duration
+		out << std::fixed << std::setprecision(3);
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		bool first = true;
+		std::size_t eventCount = 0;
+
+		for (const ThreadEvents& thread : threads)
+		{
+			out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.id << ",\"args\":{\"name\":";
+			WriteJsonString(out, thread.name);
+			out << "}}";
+			first = false;
+
+			for (const Event& event : thread.events)
+			{
+				out << ",\n{\"name\":";
+				WriteJsonString(out, event.name);
+				out << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.id
+					<< ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << '}';
+			}
+
+			eventCount += thread.events.size();
+		}
+
+		out << "\n]}\n";
+
+		if (!out)
+		{
+			Log::Warn("Failed to write cpu trace: {}", path);
+			return false;
+		}
+
+		Log::Info("Wrote cpu trace with {} events: {}", eventCount, path);
+		return true;
+	}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace FoxEngine
+{
+	// Cpu time of named scopes on every thread that opens one
+	//
+	// Each thread writes finished scopes into its own ring of events without locking, the only lock is taken
+	// once per thread when its ring is created. Snapshot copies the rings while they are being written, like the
+	// read side of a seqlock: slot fields are relaxed atomics so the overlap is not a data race, and events the
+	// owner may have overwritten during the copy are dropped. Rings keep the newest EventsPerThread events.
+	//
+	// Scope names are not copied and must outlive the profiler, string literals in practice.
+	// Instrument with the FE_PROFILE_ macros below, they compile to nothing unless FE_PROFILE is defined,
+	// which premake does for every configuration but dist
+	class CpuProfiler final
+	{
+	public:
+		static constexpr std::size_t EventsPerThread = 1 << 14;
+
+		// Deeper scopes are counted but not recorded
+		static constexpr std::uint32_t MaxDepth = 32;
+
+		struct Event final
+		{
+			const char* name = nullptr;
+			std::int64_t start = 0; // Nanoseconds since the profiler was created
+			std::int64_t end = 0;
+			std::uint32_t depth = 0;
+		};
+
+		struct ThreadEvents final
+		{
+			std::string name;
+			std::uint32_t id = 0;
+			std::vector<Event> events; // Ordered by end time
+		};
+
+		class Scope final
+		{
+		public:
+			explicit Scope(const char* name) { CpuProfiler::Get().Begin(name); }
+			~Scope() noexcept { CpuProfiler::Get().End(); }
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+			Scope(Scope&&) noexcept = delete;
+			Scope& operator=(Scope&&) noexcept = delete;
+		};
+
+		// The one instance, threads find their ring through a thread local
+		static CpuProfiler& Get();
+	public:
+		CpuProfiler(const CpuProfiler&) = delete;
+		CpuProfiler& operator=(const CpuProfiler&) = delete;
+		CpuProfiler(CpuProfiler&&) noexcept = delete;
+		CpuProfiler& operator=(CpuProfiler&&) noexcept = delete;
+
+		// Shown in the timeline and the trace, threads without one are numbered
+		void SetThreadName(std::string_view name);
+
+		void Begin(const char* name);
+		void End();
+
+		std::int64_t Now() const noexcept
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mEpoch).count();
+		}
+
+		// Events that ended at or after since, per thread in the order threads first opened a scope
+		std::vector<ThreadEvents> Snapshot(std::int64_t since = 0) const;
+
+		// Everything still held by the rings as a chrome://tracing / Perfetto json file, logs and returns false on failure
+		bool ExportChromeTrace(const std::string& path) const;
+	private:
+		// An Event as stored in the ring, read by Snapshot while the owner may be overwriting it
+		struct EventSlot final
+		{
+			std::atomic<const char*> name = nullptr;
+			std::atomic<std::int64_t> start = 0;
+			std::atomic<std::int64_t> end = 0;
+			std::atomic<std::uint32_t> depth = 0;
+		};
+
+		struct ThreadBuffer final
+		{
+			std::string name; // Guarded by mThreadsMutex
+			std::uint32_t id = 0;
+			std::unique_ptr<EventSlot[]> events = std::make_unique<EventSlot[]>(EventsPerThread);
+			std::atomic<std::uint64_t> written = 0;
+
+			// Open scopes, only touched by the owning thread
+			const char* names[MaxDepth]{};
+			std::int64_t starts[MaxDepth]{};
+			std::uint32_t depth = 0;
+		};
+
+		CpuProfiler();
+		~CpuProfiler() noexcept = default;
+
+		ThreadBuffer& Local();
+	private:
+		std::chrono::steady_clock::time_point mEpoch;
+		mutable std::mutex mThreadsMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> mThreads;
+	};
+}
+
+#if defined(FE_PROFILE)
+#	define FE_PROFILE_CONCAT_IMPL(a, b) a##b
+#	define FE_PROFILE_CONCAT(a, b) FE_PROFILE_CONCAT_IMPL(a, b)
+#	define FE_PROFILE_SCOPE(name) ::FoxEngine::CpuProfiler::Scope FE_PROFILE_CONCAT(feProfileScope, __LINE__){ name }
+#	define FE_PROFILE_BEGIN(name) ::FoxEngine::CpuProfiler::Get().Begin(name)
+#	define FE_PROFILE_END() ::FoxEngine::CpuProfiler::Get().End()
+#	define FE_PROFILE_THREAD(name) ::FoxEngine::CpuProfiler::Get().SetThreadName(name)
+#else
+#	define FE_PROFILE_SCOPE(name) ((void)0)
+#	define FE_PROFILE_BEGIN(name) ((void)0)
+#	define FE_PROFILE_END() ((void)0)
+#	define FE_PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Poly.hpp"
+#include "texture.hpp"
+#include "Renderbuffer.hpp"
+#include "ogl/StateCacheOGL.hpp"
+
+#include <string_view>
+
+//
+
+#include <glad/gl.h>
+
+namespace FoxEngine
+{
+	// Attachments are allocated larger than the area rendered to, so small resizes keep the same objects.
+	// Rendering covers the top left sub-viewport and samplers scale their coordinates by the used fraction
+	class Framebuffer
+	{
+	public:
+		static constexpr unsigned int MaxColorAttachments = 4;
+
+		// Sizes are rounded up to a multiple of this
+		static constexpr int AllocationGranularity = 64;
+
+		struct CreateInfo final
+		{
+			Texture* colors[MaxColorAttachments]{}; // Null entries are left unattached
+			unsigned int colorCount = 0;
+			Texture* depthTexture = nullptr;
+			Renderbuffer* depthRenderbuffer = nullptr;
+			std::string_view debugName;
+		};
+
+		static FoxEngine::Poly<Framebuffer> Create(const CreateInfo& info);
+
+		static constexpr int AllocationSize(int size) noexcept
+		{
+			return (size + AllocationGranularity - 1) / AllocationGranularity * AllocationGranularity;
+		}
+
+		constexpr Framebuffer() noexcept = default;
+		virtual ~Framebuffer() noexcept = default;
+		Framebuffer(const Framebuffer&) = delete;
+		Framebuffer& operator=(const Framebuffer&) = delete;
+		Framebuffer(Framebuffer&&) noexcept = delete;
+		Framebuffer& operator=(Framebuffer&&) noexcept = delete;
+
+		// Binds and restricts the viewport to the used area
+		virtual void Bind(int width, int height) = 0;
+
+		virtual bool Complete() const noexcept = 0;
+		virtual unsigned int Handle() const noexcept = 0;
+	};
+
+	class FramebufferOGL33 : public Framebuffer
+	{
+	public:
+		constexpr FramebufferOGL33() noexcept = default;
+
+		FramebufferOGL33(const CreateInfo& info)
+		{
+			glGenFramebuffers(1, &mHandle);
+			StateCacheOGL::Get().BindFramebuffer(mHandle);
+
+			// Labels need the object to exist, which happens on the first bind
+			if (GLAD_GL_KHR_debug && !info.debugName.empty())
+				glObjectLabel(GL_FRAMEBUFFER, mHandle, static_cast<int>(info.debugName.size()), info.debugName.data());
+
+			unsigned int drawBuffers[MaxColorAttachments];
+			unsigned int readBuffer = GL_NONE;
+
+			for (unsigned int slot = 0; slot < info.colorCount; ++slot)
+			{
+				if (info.colors[slot])
+				{
+					glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + slot, info.colors[slot]->Target(), info.colors[slot]->Handle(), 0);
+					drawBuffers[slot] = GL_COLOR_ATTACHMENT0 + slot;
+
+					if (readBuffer == GL_NONE)
+						readBuffer = drawBuffers[slot];
+				}
+				else
+					drawBuffers[slot] = GL_NONE;
+			}
+
+			if (info.colorCount)
+				glDrawBuffers(static_cast<int>(info.colorCount), drawBuffers);
+			else
+				glDrawBuffer(GL_NONE);
+
+			// Gl 3.3 reports a read buffer without an attachment as incomplete, depth only framebuffers included
+			glReadBuffer(readBuffer);
+
+			if (info.depthRenderbuffer)
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, info.depthRenderbuffer->Handle());
+			else if (info.depthTexture)
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, info.depthTexture->Target(), info.depthTexture->Handle(), 0);
+
+			mComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		}
+
+		virtual ~FramebufferOGL33() noexcept
+		{
+			if (mHandle)
+			{
+				StateCacheOGL::Get().ForgetFramebuffer(mHandle);
+				glDeleteFramebuffers(1, &mHandle);
+			}
+		}
+
+		FramebufferOGL33(const FramebufferOGL33&) = delete;
+		FramebufferOGL33& operator=(const FramebufferOGL33&) = delete;
+
+		FramebufferOGL33(FramebufferOGL33&& other) noexcept
+		{
+			*this = std::move(other);
+		}
+		FramebufferOGL33& operator=(FramebufferOGL33&& other) noexcept
+		{
+			std::swap(mHandle, other.mHandle);
+			std::swap(mComplete, other.mComplete);
+			return *this;
+		}
+
+		void Bind(int width, int height) override
+		{
+			StateCacheOGL::Get().BindFramebuffer(mHandle);
+			glViewport(0, 0, width, height);
+		}
+
+		bool Complete() const noexcept override { return mComplete; }
+		unsigned int Handle() const noexcept override { return mHandle; }
+	private:
+		unsigned int mHandle = 0;
+		bool mComplete = false;
+	};
+
+	inline FoxEngine::Poly<Framebuffer> Framebuffer::Create(const CreateInfo& info)
+	{
+		return Poly<Framebuffer>(NullOf<FramebufferOGL33>, info);
+	}
+}
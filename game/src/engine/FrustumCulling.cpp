@@ -0,0 +1,131 @@
+#include "FrustumCulling.hpp"
+
+#include "AabbTree.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+namespace FoxEngine
+{
+	Frustum Frustum::FromMatrix(const glm::mat4& m)
+	{
+		// Rows of the matrix, glm is column major
+		glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+		Frustum frustum;
+		frustum.planes[0] = row3 + row0; // Left
+		frustum.planes[1] = row3 - row0; // Right
+		frustum.planes[2] = row3 + row1; // Bottom
+		frustum.planes[3] = row3 - row1; // Top
+		frustum.planes[4] = row3 + row2; // Near
+		frustum.planes[5] = row3 - row2; // Far
+
+		// Normalized so the distances are comparable to the box extents
+		for (glm::vec4& plane : frustum.planes)
+			plane /= glm::length(glm::vec3(plane));
+
+		return frustum;
+	}
+
+	void CullingBatch::Clear()
+	{
+		mSize = 0;
+	}
+
+	void CullingBatch::Add(const Mesh::Bounds& bounds, const glm::mat4& world)
+	{
+		// Keep the arrays a whole number of batches long, the padding lanes are never reported
+		if (mSize % Width == 0)
+		{
+			std::size_t padded = mSize + Width;
+
+			for (std::vector<float>* array : { &mCenterX, &mCenterY, &mCenterZ, &mExtentX, &mExtentY, &mExtentZ })
+				if (array->size() < padded)
+					array->resize(padded);
+		}
+
+		Aabb box = Aabb::FromBounds(bounds, world);
+		glm::vec3 center = (box.min + box.max) * 0.5f;
+		glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+		mCenterX[mSize] = center.x;
+		mCenterY[mSize] = center.y;
+		mCenterZ[mSize] = center.z;
+		mExtentX[mSize] = extent.x;
+		mExtentY[mSize] = extent.y;
+		mExtentZ[mSize] = extent.z;
+		++mSize;
+	}
+
+	std::size_t CullingBatch::Cull(const Frustum& frustum, std::vector<std::uint8_t>& visible) const
+	{
+		visible.resize(mSize);
+
+		std::size_t visibleCount = 0;
+
+		for (std::size_t base = 0; base < mSize; base += Width)
+		{
+			std::uint32_t mask = 0xFF;
+
+#if defined(__AVX2__)
+			__m256 cx = _mm256_loadu_ps(&mCenterX[base]);
+			__m256 cy = _mm256_loadu_ps(&mCenterY[base]);
+			__m256 cz = _mm256_loadu_ps(&mCenterZ[base]);
+			__m256 ex = _mm256_loadu_ps(&mExtentX[base]);
+			__m256 ey = _mm256_loadu_ps(&mExtentY[base]);
+			__m256 ez = _mm256_loadu_ps(&mExtentZ[base]);
+
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				// Distance of the center plus the box's projected radius onto the plane normal
+				__m256 distance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(plane.x)), _mm256_mul_ps(cy, _mm256_set1_ps(plane.y))),
+					_mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+
+				__m256 radius = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(std::abs(plane.x))), _mm256_mul_ps(ey, _mm256_set1_ps(std::abs(plane.y)))),
+					_mm256_mul_ps(ez, _mm256_set1_ps(std::abs(plane.z))));
+
+				__m256 inside = _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ);
+				mask &= static_cast<std::uint32_t>(_mm256_movemask_ps(inside));
+			}
+#else
+			for (std::size_t lane = 0; lane < Width; ++lane)
+			{
+				std::size_t i = base + lane;
+
+				for (const glm::vec4& plane : frustum.planes)
+				{
+					float distance = mCenterX[i] * plane.x + mCenterY[i] * plane.y + mCenterZ[i] * plane.z + plane.w;
+					float radius = mExtentX[i] * std::abs(plane.x) + mExtentY[i] * std::abs(plane.y) + mExtentZ[i] * std::abs(plane.z);
+
+					if (!(distance + radius >= 0.0f))
+					{
+						mask &= ~(1u << lane);
+						break;
+					}
+				}
+			}
+#endif
+
+			std::size_t count = std::min(Width, mSize - base);
+
+			for (std::size_t lane = 0; lane < count; ++lane)
+			{
+				std::uint8_t isVisible = (mask >> lane) & 1;
+				visible[base + lane] = isVisible;
+				visibleCount += isVisible;
+			}
+		}
+
+		return visibleCount;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "mesh.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace FoxEngine
+{
+	// Planes point inwards, a point is inside when dot(plane.xyz, p) + plane.w >= 0 for all six
+	struct Frustum final
+	{
+		glm::vec4 planes[6];
+
+		// Gribb-Hartmann extraction, works for any projection * view
+		static Frustum FromMatrix(const glm::mat4& viewProjection);
+	};
+
+	// World space boxes stored as structure of arrays, padded to a multiple of 8 so the test runs 8 boxes at a time.
+	// With AVX2 enabled (release and dist) the batches use 256-bit lanes, otherwise the same loop runs scalar
+	class CullingBatch final
+	{
+	public:
+		static constexpr std::size_t Width = 8;
+
+		void Clear();
+
+		// Transforms the local box by the world matrix and stores the box around it
+		void Add(const Mesh::Bounds& bounds, const glm::mat4& world);
+
+		std::size_t Size() const noexcept { return mSize; }
+
+		// Resizes visible to Size(), 1 where the box intersects the frustum. Returns the visible count
+		std::size_t Cull(const Frustum& frustum, std::vector<std::uint8_t>& visible) const;
+	private:
+		std::vector<float> mCenterX, mCenterY, mCenterZ;
+		std::vector<float> mExtentX, mExtentY, mExtentZ;
+		std::size_t mSize = 0;
+	};
+}
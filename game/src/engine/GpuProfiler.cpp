@@ -0,0 +1,174 @@
+#include "GpuProfiler.hpp"
+
+#include <glad/gl.h>
+
+#include <cstdint>
+
+namespace FoxEngine
+{
+	GpuProfiler::Scope::Scope(GpuProfiler* profiler, std::string_view name)
+		: mProfiler(profiler)
+	{
+		if (mProfiler)
+			mProfiler->Push(name);
+	}
+
+	GpuProfiler::Scope::~Scope() noexcept
+	{
+		if (mProfiler)
+			mProfiler->Pop();
+	}
+
+	GpuProfiler::~GpuProfiler() noexcept
+	{
+		for (Frame& frame : mFrames)
+			if (!frame.queries.empty())
+				glDeleteQueries(static_cast<int>(frame.queries.size()), frame.queries.data());
+	}
+
+	void GpuProfiler::BeginFrame()
+	{
+		Collect();
+
+		Frame& frame = mFrames[mCurrent];
+
+		// Still in flight, skip this frame instead of stalling on it
+		mRecording = !frame.pending;
+
+		if (mRecording)
+		{
+			frame.usedQueries = 0;
+			frame.markers.clear();
+		}
+
+		mStack.clear();
+		Push("Frame");
+	}
+
+	void GpuProfiler::EndFrame()
+	{
+		while (!mStack.empty())
+			Pop();
+
+		// The root scope is never popped when not recording, only its debug group is left
+		if (!mRecording && GLAD_GL_KHR_debug)
+			glPopDebugGroup();
+
+		if (mRecording)
+		{
+			mFrames[mCurrent].pending = true;
+			mCurrent = (mCurrent + 1) % FramesInFlight;
+		}
+
+		mRecording = false;
+	}
+
+	void GpuProfiler::Push(std::string_view name)
+	{
+		if (GLAD_GL_KHR_debug)
+			glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, static_cast<int>(name.size()), name.data());
+
+		if (!mRecording)
+			return;
+
+		Frame& frame = mFrames[mCurrent];
+
+		mStack.push_back(static_cast<unsigned int>(frame.markers.size()));
+
+		Marker& marker = frame.markers.emplace_back();
+		marker.name = name;
+		marker.depth = static_cast<int>(mStack.size()) - 1;
+		marker.begin = WriteTimestamp(frame);
+	}
+
+	void GpuProfiler::Pop()
+	{
+		if (mRecording && !mStack.empty())
+		{
+			Frame& frame = mFrames[mCurrent];
+			frame.markers[mStack.back()].end = WriteTimestamp(frame);
+			mStack.pop_back();
+		}
+
+		if (GLAD_GL_KHR_debug)
+			glPopDebugGroup();
+	}
+
+	const GpuProfiler::History* GpuProfiler::GetHistory(std::string_view name) const
+	{
+		auto it = mHistory.find(name);
+		return it == mHistory.end() ? nullptr : &it->second;
+	}
+
+	unsigned int GpuProfiler::WriteTimestamp(Frame& frame)
+	{
+		if (frame.usedQueries == frame.queries.size())
+		{
+			unsigned int query = 0;
+			glGenQueries(1, &query);
+			frame.queries.push_back(query);
+		}
+
+		unsigned int index = frame.usedQueries++;
+		glQueryCounter(frame.queries[index], GL_TIMESTAMP);
+		return index;
+	}
+
+	void GpuProfiler::Collect()
+	{
+		// Oldest first, mCurrent is the slot used longest ago
+		for (unsigned int i = 0; i < FramesInFlight; ++i)
+		{
+			Frame& frame = mFrames[(mCurrent + i) % FramesInFlight];
+
+			if (!frame.pending)
+				continue;
+
+			// Queries complete in order, the last one being available covers the rest
+			int available = 0;
+			glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+			if (!available)
+				break;
+
+			Resolve(frame);
+			frame.pending = false;
+		}
+	}
+
+	void GpuProfiler::Resolve(Frame& frame)
+	{
+		std::vector<std::uint64_t> timestamps(frame.usedQueries);
+
+		for (unsigned int i = 0; i < frame.usedQueries; ++i)
+			glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+
+		mResults.clear();
+
+		for (const Marker& marker : frame.markers)
+		{
+			float milliseconds = static_cast<float>((timestamps[marker.end] - timestamps[marker.begin]) / 1'000'000.0);
+			mResults.push_back({ .name = marker.name, .depth = marker.depth, .milliseconds = milliseconds });
+		}
+
+		// Scopes missing from this frame record zero so every history stays aligned to the same offset
+		for (auto& [name, history] : mHistory)
+			history.milliseconds[mHistoryOffset] = 0.0f;
+
+		for (const Result& result : mResults)
+		{
+			auto it = mHistory.find(result.name);
+
+			if (it == mHistory.end())
+				it = mHistory.emplace(result.name, History{}).first;
+
+			// Scopes opened more than once per frame add up
+			it->second.milliseconds[mHistoryOffset] += result.milliseconds;
+		}
+
+		for (auto& [name, history] : mHistory)
+			history.average += (history.milliseconds[mHistoryOffset] - history.average) * 0.1f;
+
+		mHistoryOffset = (mHistoryOffset + 1) % HistoryLength;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace FoxEngine
+{
+	// Gpu time per named scope, nested, measured with timestamp queries
+	//
+	// Every Push and Pop writes a GL_TIMESTAMP into a query owned by the current frame. Frames sit in a ring
+	// and are resolved once their last query is available, so results lag a few frames behind and nothing
+	// waits on the gpu. A frame is not recorded when its slot is still in flight.
+	// Scopes also open a KHR_debug group when the extension exists, so captures show the same hierarchy
+	class GpuProfiler final
+	{
+	public:
+		static constexpr unsigned int FramesInFlight = 4;
+		static constexpr unsigned int HistoryLength = 240;
+
+		struct Result final
+		{
+			std::string name;
+			int depth = 0;
+			float milliseconds = 0.0f;
+		};
+
+		struct History final
+		{
+			std::array<float, HistoryLength> milliseconds{}; // Ring, oldest sample at HistoryOffset
+			float average = 0.0f;
+		};
+
+		// Pushes on construction and pops on destruction, a null profiler does nothing
+		class Scope final
+		{
+		public:
+			Scope(GpuProfiler* profiler, std::string_view name);
+			~Scope() noexcept;
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+			Scope(Scope&&) noexcept = delete;
+			Scope& operator=(Scope&&) noexcept = delete;
+		private:
+			GpuProfiler* mProfiler;
+		};
+	public:
+		GpuProfiler() = default;
+		~GpuProfiler() noexcept;
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+		GpuProfiler(GpuProfiler&&) noexcept = delete;
+		GpuProfiler& operator=(GpuProfiler&&) noexcept = delete;
+
+		// Resolves finished frames and opens the root "Frame" scope
+		void BeginFrame();
+		void EndFrame();
+
+		void Push(std::string_view name);
+		void Pop();
+
+		// Scopes of the latest resolved frame in the order they were opened
+		const std::vector<Result>& Results() const noexcept { return mResults; }
+
+		// Null for names never resolved
+		const History* GetHistory(std::string_view name) const;
+
+		unsigned int HistoryOffset() const noexcept { return mHistoryOffset; }
+	private:
+		struct Marker final
+		{
+			std::string name;
+			int depth = 0;
+			unsigned int begin = 0; // Query indices within the frame
+			unsigned int end = 0;
+		};
+
+		struct Frame final
+		{
+			std::vector<unsigned int> queries; // Grows as needed, kept across uses of the slot
+			unsigned int usedQueries = 0;
+			std::vector<Marker> markers;
+			bool pending = false;
+		};
+
+		void Collect();
+		void Resolve(Frame& frame);
+		unsigned int WriteTimestamp(Frame& frame);
+	private:
+		Frame mFrames[FramesInFlight];
+		unsigned int mCurrent = 0;
+		bool mRecording = false;
+		std::vector<unsigned int> mStack; // Open markers of the current frame
+		std::vector<Result> mResults;
+		std::map<std::string, History, std::less<>> mHistory;
+		unsigned int mHistoryOffset = 0;
+	};
+}
@@ -0,0 +1,68 @@
+#include "GpuTimer.hpp"
+
+#include <glad/gl.h>
+
+#include <cstdint>
+
+namespace FoxEngine
+{
+	GpuTimer::GpuTimer()
+	{
+		glGenQueries(Latency, mQueries);
+	}
+
+	GpuTimer::~GpuTimer() noexcept
+	{
+		glDeleteQueries(Latency, mQueries);
+	}
+
+	void GpuTimer::Begin()
+	{
+		Collect();
+
+		// Still in flight, drop this frame instead of stalling on the oldest query
+		if (mIssued[mNext])
+			return;
+
+		glBeginQuery(GL_TIME_ELAPSED, mQueries[mNext]);
+		mActive = true;
+	}
+
+	void GpuTimer::End()
+	{
+		if (!mActive)
+			return;
+
+		glEndQuery(GL_TIME_ELAPSED);
+
+		mIssued[mNext] = true;
+		mNext = (mNext + 1) % Latency;
+		mActive = false;
+	}
+
+	void GpuTimer::Collect()
+	{
+		// Oldest first, queries finish in the order they were issued
+		for (unsigned int i = 0; i < Latency; ++i)
+		{
+			unsigned int index = (mNext + i) % Latency;
+
+			if (!mIssued[index])
+				continue;
+
+			int available = 0;
+			glGetQueryObjectiv(mQueries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+
+			if (!available)
+				break;
+
+			std::uint64_t nanoseconds = 0;
+			glGetQueryObjectui64v(mQueries[index], GL_QUERY_RESULT, &nanoseconds);
+			mIssued[index] = false;
+
+			double milliseconds = nanoseconds / 1'000'000.0;
+			mMilliseconds = mHasResult ? mMilliseconds + (milliseconds - mMilliseconds) * 0.1 : milliseconds;
+			mHasResult = true;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace FoxEngine
+{
+	// Gpu time spent between Begin and End, averaged over recent frames
+	//
+	// Each measurement is a GL_TIME_ELAPSED query from a small ring. Results are collected once available so
+	// they lag a few frames behind, a frame is skipped rather than waited on when the ring is still busy.
+	// Elapsed queries can't nest, only one timer may be between Begin and End at a time
+	class GpuTimer final
+	{
+	public:
+		static constexpr unsigned int Latency = 4;
+	public:
+		GpuTimer();
+		~GpuTimer() noexcept;
+		GpuTimer(const GpuTimer&) = delete;
+		GpuTimer& operator=(const GpuTimer&) = delete;
+		GpuTimer(GpuTimer&&) noexcept = delete;
+		GpuTimer& operator=(GpuTimer&&) noexcept = delete;
+
+		void Begin();
+		void End();
+
+		// Zero until the first result arrives
+		double Milliseconds() const noexcept { return mMilliseconds; }
+
+		bool HasResult() const noexcept { return mHasResult; }
+	private:
+		void Collect();
+	private:
+		unsigned int mQueries[Latency]{};
+		bool mIssued[Latency]{};
+		unsigned int mNext = 0;
+		bool mActive = false;
+		bool mHasResult = false;
+		double mMilliseconds = 0.0;
+	};
+}
@@ -0,0 +1,38 @@
+#include "Image.hpp"
+
+#include "CpuProfiler.hpp"
+#include "vendor/stb_image.h"
+
+#include <string>
+#include <utility>
+
+namespace FoxEngine
+{
+	Image Image::FromFile(std::string_view filename)
+	{
+		FE_PROFILE_SCOPE("Decode image");
+
+		Image image;
+		image.mPixels = stbi_load(std::string(filename).c_str(), &image.mWidth, &image.mHeight, nullptr, 4);
+		return image;
+	}
+
+	Image::~Image() noexcept
+	{
+		if (mPixels)
+			stbi_image_free(mPixels);
+	}
+
+	Image::Image(Image&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	Image& Image::operator=(Image&& other) noexcept
+	{
+		std::swap(mPixels, other.mPixels);
+		std::swap(mWidth, other.mWidth);
+		std::swap(mHeight, other.mHeight);
+		return *this;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string_view>
+
+namespace FoxEngine
+{
+	// Decoded rgba8 pixels in system memory, decoding has no gpu dependency and is safe on any thread
+	class Image final
+	{
+	public:
+		// Returns an empty image on failure
+		[[nodiscard]] static Image FromFile(std::string_view filename);
+
+		Image() noexcept = default;
+		~Image() noexcept;
+		Image(const Image&) = delete;
+		Image& operator=(const Image&) = delete;
+		Image(Image&& other) noexcept;
+		Image& operator=(Image&& other) noexcept;
+
+		explicit operator bool() const { return mPixels; }
+		const unsigned char* Pixels() const noexcept { return mPixels; }
+		int Width() const noexcept { return mWidth; }
+		int Height() const noexcept { return mHeight; }
+	private:
+		unsigned char* mPixels = nullptr;
+		int mWidth = 0;
+		int mHeight = 0;
+	};
+}
@@ -0,0 +1,127 @@
+#include "MeshLoader.hpp"
+
+#include "CpuProfiler.hpp"
+#include "log.hpp"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <string>
+#include <utility>
+
+namespace FoxEngine::MeshLoader
+{
+	// Error prone, needs more logging ability
+	bool Import(std::string_view resource, std::vector<Mesh::Vertex>& vertices, std::vector<Mesh::Index>& indices)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(std::string(resource).c_str(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_ImproveCacheLocality | aiProcess_OptimizeMeshes);
+
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			Log::Warn("Failed to load model: {} with error: {}", resource, importer.GetErrorString());
+			return false;
+		}
+
+		if (scene->mNumMeshes == 0)
+		{
+			Log::Warn("Scene has no meshes: {}", resource);
+			return false;
+		}
+
+		//if (scene->mNumMeshes != 1)
+			//fe_log_warn("scene has more than one mesh, only the first will be processed");
+
+		//if (scene->mRootNode->mNumChildren != 0)
+			//fe_log_warn("root has children, they will not be processed");
+
+		aiMesh* mesh = scene->mMeshes[0];
+
+		vertices.clear();
+		vertices.reserve(mesh->mNumVertices);
+
+		indices.clear();
+		indices.reserve(mesh->mNumFaces * 3);
+
+		for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+		{
+			// A lot of this can likely be copied via memcpy
+			Mesh::Vertex vertex;
+			vertex.position.x = mesh->mVertices[i].x;
+			vertex.position.y = mesh->mVertices[i].y;
+			vertex.position.z = mesh->mVertices[i].z;
+			vertex.normal.x = mesh->mNormals[i].x;
+			vertex.normal.y = mesh->mNormals[i].y;
+			vertex.normal.z = mesh->mNormals[i].z;
+			// Add tangents when needed
+			vertex.texCoord.x = mesh->mTextureCoords[0][i].x;
+			vertex.texCoord.y = mesh->mTextureCoords[0][i].y;
+			vertices.push_back(std::move(vertex));
+		}
+
+		for (unsigned int i = 0; i < mesh->mNumFaces; ++i)
+		{
+			aiFace face = mesh->mFaces[i];
+
+			// We should support lines and points eventually...
+			if (face.mNumIndices != 3) continue;
+
+			for (unsigned int j = 0; j < face.mNumIndices; ++j)
+				indices.push_back(face.mIndices[j]);
+		}
+
+		return true;
+	}
+
+	std::optional<MeshData> Decode(std::string_view resource)
+	{
+		FE_PROFILE_SCOPE("Decode mesh");
+
+		MeshData data;
+
+		// Fast path, the cooked file is mapped and handed straight to the gpu
+		if ((data.cooked = CookedMesh::Load(resource)))
+			return data;
+
+		if (!Import(resource, data.vertices, data.indices))
+			return std::nullopt;
+
+		// Cook on a miss so the next load is fast, failing to write is not fatal
+		try
+		{
+			CookedMesh::Write(resource, data.vertices, data.indices);
+		}
+		catch (const Exception::FileRead& e)
+		{
+			Log::Warn("Failed to cook mesh {}: {}", resource, e.what());
+		}
+
+		return data;
+	}
+
+	bool Cook(std::string_view resource)
+	{
+		std::vector<Mesh::Vertex> vertices;
+		std::vector<Mesh::Index> indices;
+
+		if (!Import(resource, vertices, indices))
+		{
+			Log::Error("Failed to import mesh: {}", resource);
+			return false;
+		}
+
+		try
+		{
+			CookedMesh::Write(resource, vertices, indices);
+		}
+		catch (const Exception::FileRead& e)
+		{
+			Log::Error("Failed to cook mesh {}: {}", resource, e.what());
+			return false;
+		}
+
+		Log::Info("Cooked mesh: {}", CookedMesh::PathFor(resource));
+		return true;
+	}
+}
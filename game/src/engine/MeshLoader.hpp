@@ -0,0 +1,37 @@
+#pragma once
+
+#include "mesh.hpp"
+#include "CookedMesh.hpp"
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace FoxEngine
+{
+	// Cpu side mesh data ready to be handed to Mesh::Create
+	// Either maps a cooked file or owns the data produced by an import
+	struct MeshData final
+	{
+		std::optional<CookedMesh::View> cooked;
+		std::vector<Mesh::Vertex> vertices;
+		std::vector<Mesh::Index> indices;
+
+		std::span<const Mesh::Vertex> Vertices() const { return cooked ? cooked->vertices : std::span<const Mesh::Vertex>(vertices); }
+		std::span<const Mesh::Index> Indices() const { return cooked ? cooked->indices : std::span<const Mesh::Index>(indices); }
+	};
+
+	namespace MeshLoader
+	{
+		// Runs the full assimp import, this is slow and only used when there is no up to date cooked mesh
+		bool Import(std::string_view resource, std::vector<Mesh::Vertex>& vertices, std::vector<Mesh::Index>& indices);
+
+		// Loads the cooked mesh, importing and cooking it first if needed
+		// No gpu calls are made so this is safe to run on any thread
+		std::optional<MeshData> Decode(std::string_view resource);
+
+		// Imports the source file and writes its cooked form, used by the --cook command line
+		bool Cook(std::string_view resource);
+	}
+}
@@ -0,0 +1,334 @@
+#include "OcclusionCulling.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace FoxEngine
+{
+	OcclusionBuffer::OcclusionBuffer()
+	{
+		for (int level = 0; level < Levels; ++level)
+		{
+			std::size_t size = static_cast<std::size_t>(LevelWidth(level)) * LevelHeight(level);
+			mNearest[level].resize(size, 1.0f);
+
+			// Level 0 is read through mNearest
+			if (level > 0)
+				mFarthest[level].resize(size, 1.0f);
+		}
+	}
+
+	void OcclusionBuffer::Begin(const glm::mat4& viewProjection)
+	{
+		mViewProjection = viewProjection;
+		mStats = {};
+
+		std::fill(mNearest[0].begin(), mNearest[0].end(), 1.0f);
+	}
+
+	OcclusionBuffer::ScreenVertex OcclusionBuffer::ToScreen(const glm::vec4& clip) const
+	{
+		float inverseW = 1.0f / clip.w;
+
+		return
+		{
+			(clip.x * inverseW * 0.5f + 0.5f) * Width,
+			(clip.y * inverseW * 0.5f + 0.5f) * Height,
+			clip.z * inverseW * 0.5f + 0.5f
+		};
+	}
+
+	void OcclusionBuffer::RasterizeOccluder(const Mesh::Geometry& geometry, const glm::mat4& world)
+	{
+		++mStats.occluders;
+
+		glm::mat4 transform = mViewProjection * world;
+
+		mClipPositions.resize(geometry.positions.size());
+		for (std::size_t i = 0; i < geometry.positions.size(); ++i)
+			mClipPositions[i] = transform * glm::vec4(geometry.positions[i], 1.0f);
+
+		for (std::size_t i = 0; i + 2 < geometry.indices.size(); i += 3)
+		{
+			const glm::vec4& a = mClipPositions[geometry.indices[i + 0]];
+			const glm::vec4& b = mClipPositions[geometry.indices[i + 1]];
+			const glm::vec4& c = mClipPositions[geometry.indices[i + 2]];
+
+			// Entirely outside one of the side or far planes
+			if (a.x > a.w && b.x > b.w && c.x > c.w) continue;
+			if (a.x < -a.w && b.x < -b.w && c.x < -c.w) continue;
+			if (a.y > a.w && b.y > b.w && c.y > c.w) continue;
+			if (a.y < -a.w && b.y < -b.w && c.y < -c.w) continue;
+			if (a.z > a.w && b.z > b.w && c.z > c.w) continue;
+
+			RasterizeClipped(a, b, c);
+		}
+	}
+
+	void OcclusionBuffer::RasterizeClipped(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+	{
+		// Distance to the near plane, z = -w in gl clip space
+		auto nearDistance = [](const glm::vec4& v) { return v.z + v.w; };
+
+		if (nearDistance(a) >= 0.0f && nearDistance(b) >= 0.0f && nearDistance(c) >= 0.0f)
+		{
+			RasterizeTriangle(ToScreen(a), ToScreen(b), ToScreen(c));
+			return;
+		}
+
+		// Sutherland-Hodgman against the near plane, a triangle becomes at most a quad
+		const glm::vec4* input[3] = { &a, &b, &c };
+		glm::vec4 polygon[4];
+		int count = 0;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const glm::vec4& current = *input[i];
+			const glm::vec4& next = *input[(i + 1) % 3];
+			float currentDistance = nearDistance(current);
+			float nextDistance = nearDistance(next);
+
+			if (currentDistance >= 0.0f)
+				polygon[count++] = current;
+
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+				polygon[count++] = current + (next - current) * (currentDistance / (currentDistance - nextDistance));
+		}
+
+		if (count < 3) return;
+
+		ScreenVertex screen[4];
+		for (int i = 0; i < count; ++i)
+			screen[i] = ToScreen(polygon[i]);
+
+		for (int i = 1; i + 1 < count; ++i)
+			RasterizeTriangle(screen[0], screen[i], screen[i + 1]);
+	}
+
+	void OcclusionBuffer::RasterizeTriangle(ScreenVertex a, ScreenVertex b, ScreenVertex c)
+	{
+		float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+
+		// Occluders are closed meshes, both windings are drawn
+		if (area < 0.0f)
+		{
+			std::swap(b, c);
+			area = -area;
+		}
+
+		if (!(area > 1e-6f)) return;
+
+		int minX = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))));
+		int maxX = std::min(Width - 1, static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))));
+		int minY = std::max(0, static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))));
+		int maxY = std::min(Height - 1, static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))));
+
+		if (minX > maxX || minY > maxY) return;
+
+		++mStats.triangles;
+
+		// Edge functions as e(x, y) = x * stepX + y * stepY + offset, positive inside. Each edge weighs the opposite vertex
+		struct Edge final
+		{
+			float stepX, stepY, offset;
+		};
+
+		// Shared edges are always set up from the same end and negated for the other triangle, so a pixel on the edge
+		// lands in at least one of them instead of rounding out of both
+		auto makeEdge = [](const ScreenVertex& from, const ScreenVertex& to) -> Edge
+		{
+			bool flip = to.x < from.x || (to.x == from.x && to.y < from.y);
+			const ScreenVertex& p = flip ? to : from;
+			const ScreenVertex& q = flip ? from : to;
+
+			float stepX = -(q.y - p.y);
+			float stepY = q.x - p.x;
+			float offset = -(stepX * p.x + stepY * p.y);
+
+			return flip ? Edge{ -stepX, -stepY, -offset } : Edge{ stepX, stepY, offset };
+		};
+
+		Edge edgeA = makeEdge(b, c);
+		Edge edgeB = makeEdge(c, a);
+		Edge edgeC = makeEdge(a, b);
+
+		// Depth is affine in screen space after the divide
+		float inverseArea = 1.0f / area;
+		float depthStepX = (edgeA.stepX * a.z + edgeB.stepX * b.z + edgeC.stepX * c.z) * inverseArea;
+		float depthStepY = (edgeA.stepY * a.z + edgeB.stepY * b.z + edgeC.stepY * c.z) * inverseArea;
+		float depthOffset = (edgeA.offset * a.z + edgeB.offset * b.z + edgeC.offset * c.z) * inverseArea;
+
+		// Rows start on a multiple of 8, Width is one too so a group never leaves the row
+		int startX = minX & ~7;
+		float* depth = mNearest[0].data();
+
+		for (int y = minY; y <= maxY; ++y)
+		{
+			float centerY = y + 0.5f;
+			float* row = depth + static_cast<std::size_t>(y) * Width;
+
+#if defined(__AVX2__)
+			__m256 x = _mm256_add_ps(_mm256_set1_ps(startX + 0.5f), _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+
+			auto rowStart = [&](const Edge& edge)
+			{
+				return _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(edge.stepX)), _mm256_set1_ps(edge.stepY * centerY + edge.offset));
+			};
+
+			__m256 valueA = rowStart(edgeA);
+			__m256 valueB = rowStart(edgeB);
+			__m256 valueC = rowStart(edgeC);
+			__m256 z = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(depthStepX)), _mm256_set1_ps(depthStepY * centerY + depthOffset));
+
+			__m256 stepA = _mm256_set1_ps(edgeA.stepX * 8.0f);
+			__m256 stepB = _mm256_set1_ps(edgeB.stepX * 8.0f);
+			__m256 stepC = _mm256_set1_ps(edgeC.stepX * 8.0f);
+			__m256 stepZ = _mm256_set1_ps(depthStepX * 8.0f);
+			__m256 zero = _mm256_setzero_ps();
+
+			for (int groupX = startX; groupX <= maxX; groupX += 8)
+			{
+				__m256 inside = _mm256_and_ps(
+					_mm256_and_ps(_mm256_cmp_ps(valueA, zero, _CMP_GE_OQ), _mm256_cmp_ps(valueB, zero, _CMP_GE_OQ)),
+					_mm256_cmp_ps(valueC, zero, _CMP_GE_OQ));
+
+				if (_mm256_movemask_ps(inside))
+				{
+					__m256 current = _mm256_loadu_ps(row + groupX);
+					__m256 nearest = _mm256_min_ps(current, z);
+					_mm256_storeu_ps(row + groupX, _mm256_blendv_ps(current, nearest, inside));
+				}
+
+				valueA = _mm256_add_ps(valueA, stepA);
+				valueB = _mm256_add_ps(valueB, stepB);
+				valueC = _mm256_add_ps(valueC, stepC);
+				z = _mm256_add_ps(z, stepZ);
+			}
+#else
+			for (int groupX = startX; groupX <= maxX; groupX += 8)
+			{
+				for (int lane = 0; lane < 8; ++lane)
+				{
+					float centerX = groupX + lane + 0.5f;
+
+					float valueA = edgeA.stepX * centerX + edgeA.stepY * centerY + edgeA.offset;
+					float valueB = edgeB.stepX * centerX + edgeB.stepY * centerY + edgeB.offset;
+					float valueC = edgeC.stepX * centerX + edgeC.stepY * centerY + edgeC.offset;
+
+					if (valueA >= 0.0f && valueB >= 0.0f && valueC >= 0.0f)
+					{
+						float z = depthStepX * centerX + depthStepY * centerY + depthOffset;
+						row[groupX + lane] = std::min(row[groupX + lane], z);
+					}
+				}
+			}
+#endif
+		}
+	}
+
+	void OcclusionBuffer::BuildHierarchy()
+	{
+		for (int level = 1; level < Levels; ++level)
+		{
+			int width = LevelWidth(level);
+			int height = LevelHeight(level);
+			int sourceWidth = LevelWidth(level - 1);
+
+			const std::vector<float>& sourceNearest = mNearest[level - 1];
+			const std::vector<float>& sourceFarthest = level == 1 ? mNearest[0] : mFarthest[level - 1];
+
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					std::size_t i00 = static_cast<std::size_t>(y * 2) * sourceWidth + x * 2;
+					std::size_t i10 = i00 + 1;
+					std::size_t i01 = i00 + sourceWidth;
+					std::size_t i11 = i01 + 1;
+
+					std::size_t target = static_cast<std::size_t>(y) * width + x;
+					mNearest[level][target] = std::min({ sourceNearest[i00], sourceNearest[i10], sourceNearest[i01], sourceNearest[i11] });
+					mFarthest[level][target] = std::max({ sourceFarthest[i00], sourceFarthest[i10], sourceFarthest[i01], sourceFarthest[i11] });
+				}
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsVisible(const Aabb& box)
+	{
+		++mStats.tested;
+
+		float minX = static_cast<float>(Width);
+		float maxX = 0.0f;
+		float minY = static_cast<float>(Height);
+		float maxY = 0.0f;
+		float nearestDepth = 1.0f;
+
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			glm::vec3 position(
+				corner & 1 ? box.max.x : box.min.x,
+				corner & 2 ? box.max.y : box.min.y,
+				corner & 4 ? box.max.z : box.min.z);
+
+			glm::vec4 clip = mViewProjection * glm::vec4(position, 1.0f);
+
+			if (clip.z < -clip.w || clip.w <= 0.0f) return true;
+
+			ScreenVertex screen = ToScreen(clip);
+			minX = std::min(minX, screen.x);
+			maxX = std::max(maxX, screen.x);
+			minY = std::min(minY, screen.y);
+			maxY = std::max(maxY, screen.y);
+			nearestDepth = std::min(nearestDepth, screen.z);
+		}
+
+		if (maxX < 0.0f || minX >= Width || maxY < 0.0f || minY >= Height) return true;
+
+		int x0 = std::max(0, static_cast<int>(minX));
+		int x1 = std::min(Width - 1, static_cast<int>(maxX));
+		int y0 = std::max(0, static_cast<int>(minY));
+		int y1 = std::min(Height - 1, static_cast<int>(maxY));
+
+		int start = 0;
+		while (start + 1 < Levels && ((x1 >> start) - (x0 >> start) > 1 || (y1 >> start) - (y0 >> start) > 1))
+			++start;
+
+		// Two refinements at most, 8x8 texels, anything still undecided is drawn
+		int finest = std::max(0, start - 2);
+
+		for (int level = start; level >= finest; --level)
+		{
+			int width = LevelWidth(level);
+			const std::vector<float>& nearest = mNearest[level];
+			const std::vector<float>& farthest = level == 0 ? mNearest[0] : mFarthest[level];
+
+			bool undecided = false;
+
+			for (int y = y0 >> level; y <= y1 >> level; ++y)
+			{
+				for (int x = x0 >> level; x <= x1 >> level; ++x)
+				{
+					std::size_t i = static_cast<std::size_t>(y) * width + x;
+
+					if (nearestDepth > farthest[i]) continue;
+					if (nearestDepth <= nearest[i]) return true;
+
+					undecided = true;
+				}
+			}
+
+			if (!undecided)
+			{
+				++mStats.occluded;
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
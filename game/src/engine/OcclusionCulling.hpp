@@ -0,0 +1,75 @@
+#pragma once
+
+#include "AabbTree.hpp"
+#include "mesh.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <vector>
+
+namespace FoxEngine
+{
+	// Low resolution depth buffer filled on the cpu, used to skip draws hidden behind large occluders
+	//
+	// Each frame: Begin with the camera, rasterize the occluders, BuildHierarchy, then test candidates with IsVisible.
+	// Depth is z / w mapped to [0, 1] with 1 at the far plane, each pixel keeps the nearest occluder. Rows are
+	// rasterized 8 pixels at a time, with 256-bit lanes when AVX2 is enabled (release and dist).
+	//
+	// The hierarchy halves the resolution per level and keeps the nearest and farthest depth of the texels below.
+	// A box starts at the level where its screen rectangle covers at most 2x2 texels: if it is behind the farthest
+	// depth of every texel it is hidden, if it is in front of the nearest depth of any texel it is visible,
+	// otherwise the test moves down a level. Tests are conservative, anything not proven hidden is visible
+	class OcclusionBuffer final
+	{
+	public:
+		static constexpr int Width = 256;
+		static constexpr int Height = 128;
+		static constexpr int Levels = 8; // Down to 2x1
+
+		struct Stats final
+		{
+			unsigned int occluders = 0;
+			unsigned int triangles = 0; // Rasterized after clipping and rejection
+			unsigned int tested = 0;
+			unsigned int occluded = 0;
+		};
+	public:
+		OcclusionBuffer();
+
+		// Clears to the far plane, occluders and boxes are projected with this matrix until the next Begin
+		void Begin(const glm::mat4& viewProjection);
+
+		void RasterizeOccluder(const Mesh::Geometry& geometry, const glm::mat4& world);
+
+		// Call once after the last occluder and before the first test
+		void BuildHierarchy();
+
+		// Boxes crossing the near plane or leaving the buffer are always visible
+		bool IsVisible(const Aabb& box);
+
+		const Stats& GetStats() const noexcept { return mStats; }
+	private:
+		struct ScreenVertex final
+		{
+			float x, y, z;
+		};
+
+		void RasterizeClipped(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+		void RasterizeTriangle(ScreenVertex a, ScreenVertex b, ScreenVertex c);
+
+		ScreenVertex ToScreen(const glm::vec4& clip) const;
+
+		static int LevelWidth(int level) { return Width >> level; }
+		static int LevelHeight(int level) { return Height >> level; }
+	private:
+		glm::mat4 mViewProjection;
+
+		// Level 0 is the depth buffer itself, its nearest and farthest depth are the same
+		std::array<std::vector<float>, Levels> mNearest;
+		std::array<std::vector<float>, Levels> mFarthest;
+
+		std::vector<glm::vec4> mClipPositions;
+		Stats mStats;
+	};
+}
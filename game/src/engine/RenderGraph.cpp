@@ -0,0 +1,548 @@
+#include "RenderGraph.hpp"
+
+#include "Framebuffer.hpp"
+#include "GpuProfiler.hpp"
+#include "Renderbuffer.hpp"
+#include "log.hpp"
+#include "ogl/StateCacheOGL.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace FoxEngine
+{
+	static constexpr unsigned int RenderbufferKeyBit = 1u << 31;
+
+	void RenderGraph::PassBuilder::WriteColor(unsigned int slot, Resource resource, bool clear, const glm::vec4& clearColor)
+	{
+		if (slot >= MaxColorAttachments)
+			throw std::runtime_error("Color attachment slot out of range");
+
+		mPass.colors[slot] = { resource, clear, clearColor };
+		mPass.colorCount = std::max(mPass.colorCount, slot + 1);
+	}
+
+	void RenderGraph::PassBuilder::WriteDepth(Resource resource, bool clear)
+	{
+		mPass.depth = { resource, clear };
+	}
+
+	void RenderGraph::PassBuilder::Read(Resource resource)
+	{
+		mPass.reads.push_back(resource);
+		mGraph.mResources[resource.index].sampled = true;
+	}
+
+	RenderGraph::RenderGraph() = default;
+
+	RenderGraph::~RenderGraph() noexcept
+	{
+		Reset();
+		ReleasePool(true);
+	}
+
+	void RenderGraph::Reset()
+	{
+		for (auto& physical : mPool)
+			physical->inUse = false;
+
+		for (std::size_t i = 0; i < mPassCount; ++i)
+			if (mPasses[i].execute.destroy)
+				mPasses[i].execute.destroy(mPasses[i].execute.object);
+
+		mResourceCount = 0;
+		mPassCount = 0;
+		mCallbackBlock = 0;
+		mCallbackOffset = 0;
+	}
+
+	RenderGraph::Resource RenderGraph::CreateTexture(std::string_view name, const TextureDesc& desc)
+	{
+		if (mResourceCount == mResources.size())
+			mResources.emplace_back();
+
+		// The name keeps its buffer, everything else starts over
+		ResourceData& resource = mResources[mResourceCount];
+		resource = { .name = std::move(resource.name), .desc = desc };
+		resource.name.assign(name);
+
+		return { static_cast<std::uint32_t>(mResourceCount++) };
+	}
+
+	RenderGraph::Resource RenderGraph::CreatePersistentTexture(std::string_view name, const TextureDesc& desc, bool* created)
+	{
+		TextureDesc allocation = AllocationFor(desc);
+		auto it = mPersistent.find(name);
+
+		if (created)
+			*created = false;
+
+		if (it == mPersistent.end() || it->second->desc != allocation)
+		{
+			if (it != mPersistent.end())
+			{
+				DropFramebuffers(it->second.get());
+				mPersistent.erase(it);
+			}
+
+			it = mPersistent.emplace(std::string(name), CreatePhysical(allocation, false, name)).first;
+
+			if (created)
+				*created = true;
+		}
+
+		Resource resource = CreateTexture(name, desc);
+
+		ResourceData& data = mResources[resource.index];
+		data.output = true;
+		data.persistent = true;
+		data.physical = it->second.get();
+
+		return resource;
+	}
+
+	void RenderGraph::MarkOutput(Resource resource)
+	{
+		mResources[resource.index].output = true;
+	}
+
+	RenderGraph::PassData& RenderGraph::NewPass(std::string_view name)
+	{
+		if (mPassCount == mPasses.size())
+			mPasses.emplace_back();
+
+		PassData& pass = mPasses[mPassCount++];
+		pass = { .name = std::move(pass.name), .reads = std::move(pass.reads) };
+		pass.name.assign(name);
+		pass.reads.clear();
+
+		return pass;
+	}
+
+	void* RenderGraph::AllocateCallback(std::size_t size, std::size_t alignment)
+	{
+		// A block too small for the callback is skipped for the rest of the frame
+		for (;; ++mCallbackBlock, mCallbackOffset = 0)
+		{
+			if (mCallbackBlock == mCallbackBlocks.size())
+			{
+				std::size_t blockSize = std::max(size, CallbackBlockSize);
+				mCallbackBlocks.push_back({ std::make_unique<std::byte[]>(blockSize), blockSize });
+			}
+
+			CallbackBlock& block = mCallbackBlocks[mCallbackBlock];
+			std::size_t offset = (mCallbackOffset + alignment - 1) / alignment * alignment;
+
+			if (offset + size <= block.size)
+			{
+				mCallbackOffset = offset + size;
+				return block.data.get() + offset;
+			}
+		}
+	}
+
+	void RenderGraph::Execute()
+	{
+		++mFrame;
+		mStats = {};
+		mStats.passes = static_cast<unsigned int>(mPassCount);
+
+		for (std::size_t i = 0; i < mResourceCount; ++i)
+			if (mResources[i].persistent)
+				mResources[i].physical->lastUsedFrame = mFrame;
+
+		Cull();
+		ComputeLifetimes();
+
+		// Anything bound outside the graph may have changed the framebuffer since the last frame
+		mCurrentFramebuffer = ~0u;
+
+		for (int i = 0; i < static_cast<int>(mPassCount); ++i)
+		{
+			PassData& pass = mPasses[i];
+
+			if (!pass.alive)
+				continue;
+
+			auto forEachResource = [&](auto&& function)
+			{
+				for (unsigned int slot = 0; slot < pass.colorCount; ++slot)
+					if (pass.colors[slot].resource)
+						function(mResources[pass.colors[slot].resource.index]);
+
+				if (pass.depth.resource)
+					function(mResources[pass.depth.resource.index]);
+
+				for (Resource read : pass.reads)
+					function(mResources[read.index]);
+			};
+
+			forEachResource([&](ResourceData& resource)
+			{
+				if (resource.firstPass == i && !resource.physical)
+					resource.physical = Acquire(resource);
+			});
+
+			{
+				GpuProfiler::Scope scope(mProfiler, pass.name);
+
+				BeginPass(pass);
+				pass.execute.invoke(pass.execute.object, *this);
+			}
+
+			// Returned to the pool, a later pass with the same description reuses the object
+			forEachResource([&](ResourceData& resource)
+			{
+				if (resource.lastPass == i && resource.physical && !resource.persistent)
+					resource.physical->inUse = false;
+			});
+		}
+
+		ReleasePool(false);
+
+		mStats.physicalResources = static_cast<unsigned int>(mPool.size());
+		mStats.persistentResources = static_cast<unsigned int>(mPersistent.size());
+		mStats.framebuffers = static_cast<unsigned int>(mFramebuffers.size());
+		mStats.totalAllocations = mTotalAllocations;
+	}
+
+	Texture& RenderGraph::GetTexture(Resource resource)
+	{
+		Physical* physical = mResources[resource.index].physical;
+
+		if (!physical || !physical->texture)
+			throw std::runtime_error("Render graph resource has no texture");
+
+		return *physical->texture;
+	}
+
+	glm::vec2 RenderGraph::UvScale(Resource resource) const
+	{
+		const ResourceData& data = mResources[resource.index];
+
+		if (!data.physical)
+			return glm::vec2(1.0f);
+
+		return glm::vec2(data.desc.width, data.desc.height) / glm::vec2(data.physical->desc.width, data.physical->desc.height);
+	}
+
+	void RenderGraph::Cull()
+	{
+		// Walks the passes backwards tracking which resources a later pass or an output still needs
+		std::vector<bool>& needed = mNeeded;
+		needed.assign(mResourceCount, false);
+
+		for (std::size_t i = 0; i < mResourceCount; ++i)
+			needed[i] = mResources[i].output;
+
+		for (std::size_t i = mPassCount; i-- > 0;)
+		{
+			PassData& pass = mPasses[i];
+
+			pass.alive = pass.sideEffect;
+
+			for (unsigned int slot = 0; slot < pass.colorCount; ++slot)
+				if (pass.colors[slot].resource && needed[pass.colors[slot].resource.index])
+					pass.alive = true;
+
+			if (pass.depth.resource && needed[pass.depth.resource.index])
+				pass.alive = true;
+
+			if (!pass.alive)
+			{
+				++mStats.culledPasses;
+				continue;
+			}
+
+			// A cleared attachment doesn't depend on earlier passes, a loaded one does
+			for (unsigned int slot = 0; slot < pass.colorCount; ++slot)
+				if (pass.colors[slot].resource)
+					needed[pass.colors[slot].resource.index] = !pass.colors[slot].clear;
+
+			if (pass.depth.resource)
+				needed[pass.depth.resource.index] = !pass.depth.clear;
+
+			for (Resource read : pass.reads)
+				needed[read.index] = true;
+		}
+	}
+
+	void RenderGraph::ComputeLifetimes()
+	{
+		for (int i = 0; i < static_cast<int>(mPassCount); ++i)
+		{
+			const PassData& pass = mPasses[i];
+
+			if (!pass.alive)
+				continue;
+
+			auto use = [&](Resource resource)
+			{
+				ResourceData& data = mResources[resource.index];
+
+				if (data.firstPass < 0)
+					data.firstPass = i;
+
+				data.lastPass = i;
+			};
+
+			for (unsigned int slot = 0; slot < pass.colorCount; ++slot)
+				if (pass.colors[slot].resource)
+					use(pass.colors[slot].resource);
+
+			if (pass.depth.resource)
+				use(pass.depth.resource);
+
+			for (Resource read : pass.reads)
+				use(read);
+		}
+
+		for (std::size_t i = 0; i < mResourceCount; ++i)
+		{
+			ResourceData& resource = mResources[i];
+
+			if (resource.firstPass < 0)
+				continue;
+
+			++mStats.resources;
+
+			// Outputs are never handed back during the frame
+			if (resource.output)
+				resource.lastPass = static_cast<int>(mPassCount);
+		}
+	}
+
+	RenderGraph::Physical* RenderGraph::Acquire(const ResourceData& resource)
+	{
+		bool renderbuffer = resource.desc.format == ImageFormat::D24 && !resource.sampled && !resource.output;
+
+		TextureDesc allocation = AllocationFor(resource.desc);
+
+		// An entry of the exact allocation size wins, otherwise the smallest larger one that hasn't served
+		// smaller sizes for too long
+		Physical* best = nullptr;
+
+		for (auto& physical : mPool)
+		{
+			const TextureDesc& desc = physical->desc;
+
+			if (physical->inUse || desc.format != allocation.format || desc.filter != allocation.filter || (physical->renderbuffer != nullptr) != renderbuffer)
+				continue;
+
+			if (desc == allocation)
+			{
+				best = physical.get();
+				break;
+			}
+
+			if (desc.width < allocation.width || desc.height < allocation.height || physical->shrinkFrames >= ShrinkFrames)
+				continue;
+
+			if (!best || desc.width * desc.height < best->desc.width * best->desc.height)
+				best = physical.get();
+		}
+
+		if (best)
+		{
+			if (best->desc == allocation)
+				best->shrinkFrames = 0;
+			else if (best->lastUsedFrame != mFrame)
+				++best->shrinkFrames;
+
+			best->inUse = true;
+			best->lastUsedFrame = mFrame;
+			return best;
+		}
+
+		auto physical = CreatePhysical(allocation, renderbuffer, resource.name);
+		physical->inUse = true;
+		physical->lastUsedFrame = mFrame;
+
+		return mPool.emplace_back(std::move(physical)).get();
+	}
+
+	std::unique_ptr<RenderGraph::Physical> RenderGraph::CreatePhysical(const TextureDesc& allocation, bool renderbuffer, std::string_view name)
+	{
+		auto physical = std::make_unique<Physical>();
+		physical->desc = allocation;
+		physical->lastUsedFrame = mFrame;
+
+		if (renderbuffer)
+		{
+			physical->renderbuffer = Renderbuffer::Create({
+				.width = allocation.width,
+				.height = allocation.height,
+				.format = allocation.format,
+				.debugName = name
+			}).MakeUnique();
+		}
+		else
+		{
+			physical->texture = Texture::Create({
+				.width = allocation.width,
+				.height = allocation.height,
+				.format = allocation.format,
+				.wrap = Texture::Wrap::Clamp,
+				.min = allocation.filter,
+				.mag = allocation.filter,
+				.debugName = name
+			}).MakeUnique();
+		}
+
+		++mStats.allocations;
+		++mTotalAllocations;
+
+		return physical;
+	}
+
+	RenderGraph::TextureDesc RenderGraph::AllocationFor(const TextureDesc& desc)
+	{
+		TextureDesc allocation = desc;
+		allocation.width = Framebuffer::AllocationSize(desc.width);
+		allocation.height = Framebuffer::AllocationSize(desc.height);
+
+		return allocation;
+	}
+
+	unsigned int RenderGraph::KeyHandle(const Physical* physical)
+	{
+		if (!physical)
+			return 0;
+
+		if (physical->renderbuffer)
+			return physical->renderbuffer->Handle() | RenderbufferKeyBit;
+
+		return physical->texture->Handle();
+	}
+
+	void RenderGraph::BeginPass(const PassData& pass)
+	{
+		auto& stateCache = StateCacheOGL::Get();
+
+		// Attachments of a pass are expected to share one size
+		const TextureDesc* size = nullptr;
+
+		for (unsigned int slot = 0; slot < pass.colorCount && !size; ++slot)
+			if (pass.colors[slot].resource)
+				size = &mResources[pass.colors[slot].resource.index].desc;
+
+		if (!size && pass.depth.resource)
+			size = &mResources[pass.depth.resource.index].desc;
+
+		Framebuffer* framebuffer = FramebufferFor(pass);
+		unsigned int handle = framebuffer ? framebuffer->Handle() : 0;
+
+		if (handle != mCurrentFramebuffer)
+		{
+			mCurrentFramebuffer = handle;
+			++mStats.framebufferBinds;
+		}
+
+		if (framebuffer)
+			framebuffer->Bind(size->width, size->height);
+		else
+			stateCache.BindFramebuffer(0);
+
+		for (unsigned int slot = 0; slot < pass.colorCount; ++slot)
+		{
+			const Attachment& attachment = pass.colors[slot];
+
+			if (attachment.resource && attachment.clear)
+				glClearBufferfv(GL_COLOR, static_cast<int>(slot), &attachment.clearColor[0]);
+		}
+
+		if (pass.depth.resource && pass.depth.clear)
+		{
+			float one = 1.0f;
+			stateCache.DepthMask(true);
+			glClearBufferfv(GL_DEPTH, 0, &one);
+		}
+	}
+
+	Framebuffer* RenderGraph::FramebufferFor(const PassData& pass)
+	{
+		FramebufferKey key{};
+
+		for (unsigned int slot = 0; slot < pass.colorCount; ++slot)
+			if (pass.colors[slot].resource)
+				key[slot] = KeyHandle(mResources[pass.colors[slot].resource.index].physical);
+
+		if (pass.depth.resource)
+			key[4] = KeyHandle(mResources[pass.depth.resource.index].physical);
+
+		// Passes without attachments draw to the default framebuffer
+		if (key == FramebufferKey{})
+			return nullptr;
+
+		if (auto it = mFramebuffers.find(key); it != mFramebuffers.end())
+			return it->second.get();
+
+		Framebuffer::CreateInfo info{ .colorCount = pass.colorCount, .debugName = pass.name };
+
+		for (unsigned int slot = 0; slot < pass.colorCount; ++slot)
+			if (pass.colors[slot].resource)
+				info.colors[slot] = mResources[pass.colors[slot].resource.index].physical->texture.get();
+
+		if (pass.depth.resource)
+		{
+			Physical* physical = mResources[pass.depth.resource.index].physical;
+			info.depthTexture = physical->texture.get();
+			info.depthRenderbuffer = physical->renderbuffer.get();
+		}
+
+		std::unique_ptr<Framebuffer> framebuffer = Framebuffer::Create(info).MakeUnique();
+
+		if (!framebuffer->Complete())
+			Log::Error("Incomplete framebuffer for render pass: {}", pass.name);
+
+		return mFramebuffers.emplace(key, std::move(framebuffer)).first->second.get();
+	}
+
+	void RenderGraph::ReleasePool(bool all)
+	{
+		auto expired = [&](const Physical& physical)
+		{
+			return all || (!physical.inUse && mFrame - physical.lastUsedFrame > FramesUntilRelease);
+		};
+
+		for (auto& physical : mPool)
+			if (expired(*physical))
+				DropFramebuffers(physical.get());
+
+		std::erase_if(mPool, [&](const std::unique_ptr<Physical>& physical) { return expired(*physical); });
+
+		for (auto it = mPersistent.begin(); it != mPersistent.end();)
+		{
+			if (!expired(*it->second))
+			{
+				++it;
+				continue;
+			}
+
+			DropFramebuffers(it->second.get());
+			it = mPersistent.erase(it);
+		}
+	}
+
+	void RenderGraph::DropFramebuffers(const Physical* physical)
+	{
+		unsigned int handle = KeyHandle(physical);
+
+		for (auto it = mFramebuffers.begin(); it != mFramebuffers.end();)
+		{
+			if (std::find(it->first.begin(), it->first.end(), handle) == it->first.end())
+			{
+				++it;
+				continue;
+			}
+
+			if (mCurrentFramebuffer == it->second->Handle())
+				mCurrentFramebuffer = ~0u;
+
+			it = mFramebuffers.erase(it);
+		}
+	}
+}
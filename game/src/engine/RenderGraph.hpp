@@ -0,0 +1,255 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace FoxEngine
+{
+	class Renderbuffer;
+	class Framebuffer;
+	class GpuProfiler;
+
+	// Frame description of passes and the attachments they use, rebuilt every frame
+	//
+	// Resources are virtual until Execute. Passes that contribute nothing to an output or a side effect are
+	// culled, then the surviving passes get physical textures and renderbuffers from a pool owned by the graph.
+	// A physical resource goes back to the pool after the last pass using it, so resources with the same
+	// description and lifetimes that don't overlap share one gl object. Gl 3.3 has no memory aliasing, sharing
+	// the object is the closest equivalent. Pool entries that go unused for a few frames are deleted.
+	//
+	// Depth that is never sampled is backed by a renderbuffer, everything else by a texture. Framebuffers are
+	// cached per attachment set, consecutive passes with the same attachments share one bind.
+	//
+	// Persistent textures keep their contents from one frame to the next, for history buffers. They are
+	// outputs of every frame they are used in and are released like pool entries once no frame asks for them.
+	//
+	// Physical resources are allocated with Framebuffer headroom and passes render to the sub-viewport of the
+	// resource size, so resizing by a few pixels reuses the pool. A larger pool entry keeps serving a smaller
+	// size for ShrinkFrames frames before a tighter one is allocated. Samplers scale by UvScale
+	//
+	// Building the frame doesn't allocate once the graph has seen it: pass and resource entries keep their names
+	// and read lists from earlier frames, and execute callbacks are stored in blocks that are reused every frame
+	class RenderGraph final
+	{
+		struct PassData;
+	public:
+		static constexpr unsigned int MaxColorAttachments = 4;
+
+		struct Resource final
+		{
+			std::uint32_t index = ~0u;
+
+			explicit operator bool() const noexcept { return index != ~0u; }
+		};
+
+		struct TextureDesc final
+		{
+			int width = 0;
+			int height = 0;
+			ImageFormat format = ImageFormat::Rgba8;
+			Texture::Filter filter = Texture::Filter::Nearest;
+
+			auto operator<=>(const TextureDesc&) const = default;
+		};
+
+		// Unless cleared, an attachment keeps what earlier passes wrote
+		struct Attachment final
+		{
+			Resource resource;
+			bool clear = false;
+			glm::vec4 clearColor{}; // Depth clears to 1
+		};
+
+		class PassBuilder final
+		{
+		public:
+			// Color attachments are bound in slot order, matching the fragment shader outputs
+			void WriteColor(unsigned int slot, Resource resource, bool clear = false, const glm::vec4& clearColor = {});
+			void WriteDepth(Resource resource, bool clear = false);
+
+			// Sampled by the pass, the texture is available through RenderGraph::GetTexture
+			void Read(Resource resource);
+
+			// Never culled, for passes whose effect is outside the graph
+			void SideEffect() { mPass.sideEffect = true; }
+		private:
+			friend class RenderGraph;
+
+			PassBuilder(RenderGraph& graph, PassData& pass) : mGraph(graph), mPass(pass) {}
+
+			RenderGraph& mGraph;
+			PassData& mPass;
+		};
+
+		struct Stats final
+		{
+			unsigned int passes = 0;
+			unsigned int culledPasses = 0;
+			unsigned int resources = 0; // Virtual resources used by live passes
+			unsigned int physicalResources = 0; // Pool size after the frame
+			unsigned int persistentResources = 0;
+			unsigned int allocations = 0; // Physical resources created this frame
+			unsigned int totalAllocations = 0; // Since the graph was created
+			unsigned int framebuffers = 0;
+			unsigned int framebufferBinds = 0;
+		};
+	public:
+		RenderGraph();
+		~RenderGraph() noexcept;
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+		RenderGraph(RenderGraph&&) noexcept = delete;
+		RenderGraph& operator=(RenderGraph&&) noexcept = delete;
+
+		// Drops the passes and resources of the previous frame, the pool is kept
+		void Reset();
+
+		Resource CreateTexture(std::string_view name, const TextureDesc& desc);
+
+		// Same texture every frame the name and allocation stay the same. Otherwise a new one is created and
+		// created is set, its contents are undefined
+		Resource CreatePersistentTexture(std::string_view name, const TextureDesc& desc, bool* created = nullptr);
+
+		// Keeps the resource and the passes producing it alive, its texture stays valid until the next Reset
+		void MarkOutput(Resource resource);
+
+		// Setup runs right away with a PassBuilder&, execute is kept until Reset and called with the graph
+		template<class SetupFunction, class ExecuteFunction>
+		void AddPass(std::string_view name, SetupFunction&& setup, ExecuteFunction&& execute);
+
+		// Culls, allocates and runs the passes in the order they were added
+		void Execute();
+
+		// Valid while the pass reading or writing it runs, and for outputs until the next Reset
+		Texture& GetTexture(Resource resource);
+
+		const TextureDesc& GetDesc(Resource resource) const { return mResources[resource.index].desc; }
+
+		// Fraction of the physical texture covered by the resource, valid while GetTexture is
+		glm::vec2 UvScale(Resource resource) const;
+
+		const Stats& GetStats() const noexcept { return mStats; }
+
+		// Each pass that runs is timed as a scope named after it, null disables it
+		void SetProfiler(GpuProfiler* profiler) noexcept { mProfiler = profiler; }
+	private:
+		struct Physical final
+		{
+			TextureDesc desc; // Allocated size
+			std::unique_ptr<Texture> texture;
+			std::unique_ptr<Renderbuffer> renderbuffer;
+			std::uint64_t lastUsedFrame = 0;
+			int shrinkFrames = 0; // Consecutive frames spent serving a smaller allocation size
+			bool inUse = false;
+		};
+
+		struct ResourceData final
+		{
+			std::string name;
+			TextureDesc desc;
+			bool output = false;
+			bool sampled = false;
+			bool persistent = false;
+			int firstPass = -1;
+			int lastPass = -1;
+			Physical* physical = nullptr;
+		};
+
+		// Type erased execute function, the object lives in the callback blocks
+		struct Callback final
+		{
+			void* object = nullptr;
+			void (*invoke)(void* object, RenderGraph& graph) = nullptr;
+			void (*destroy)(void* object) noexcept = nullptr;
+		};
+
+		struct PassData final
+		{
+			std::string name;
+			Callback execute;
+			Attachment colors[MaxColorAttachments];
+			unsigned int colorCount = 0;
+			Attachment depth;
+			std::vector<Resource> reads;
+			bool sideEffect = false;
+			bool alive = false;
+		};
+
+		// Color handles then the depth handle, zero where unused. Renderbuffer handles have the top bit set
+		// since they are named separately from textures
+		using FramebufferKey = std::array<unsigned int, 5>;
+
+		static constexpr std::uint64_t FramesUntilRelease = 3;
+		static constexpr int ShrinkFrames = 60;
+		static constexpr std::size_t CallbackBlockSize = 4096;
+
+		PassData& NewPass(std::string_view name);
+		void* AllocateCallback(std::size_t size, std::size_t alignment);
+
+		void Cull();
+		void ComputeLifetimes();
+		Physical* Acquire(const ResourceData& resource);
+		std::unique_ptr<Physical> CreatePhysical(const TextureDesc& allocation, bool renderbuffer, std::string_view name);
+		static TextureDesc AllocationFor(const TextureDesc& desc);
+		static unsigned int KeyHandle(const Physical* physical);
+		void BeginPass(const PassData& pass);
+		void ReleasePool(bool all);
+		void DropFramebuffers(const Physical* physical);
+		Framebuffer* FramebufferFor(const PassData& pass);
+	private:
+		// Entries past the counts are left over from earlier frames and reused
+		std::vector<ResourceData> mResources;
+		std::vector<PassData> mPasses;
+		std::size_t mResourceCount = 0;
+		std::size_t mPassCount = 0;
+		std::vector<bool> mNeeded; // Scratch for Cull
+
+		struct CallbackBlock final
+		{
+			std::unique_ptr<std::byte[]> data;
+			std::size_t size = 0;
+		};
+
+		std::vector<CallbackBlock> mCallbackBlocks;
+		std::size_t mCallbackBlock = 0;
+		std::size_t mCallbackOffset = 0;
+		std::vector<std::unique_ptr<Physical>> mPool;
+		std::map<std::string, std::unique_ptr<Physical>, std::less<>> mPersistent;
+		std::map<FramebufferKey, std::unique_ptr<Framebuffer>> mFramebuffers;
+		unsigned int mCurrentFramebuffer = 0;
+		std::uint64_t mFrame = 0;
+		Stats mStats;
+		unsigned int mTotalAllocations = 0;
+		GpuProfiler* mProfiler = nullptr;
+	};
+
+	template<class SetupFunction, class ExecuteFunction>
+	void RenderGraph::AddPass(std::string_view name, SetupFunction&& setup, ExecuteFunction&& execute)
+	{
+		using Function = std::decay_t<ExecuteFunction>;
+		static_assert(alignof(Function) <= alignof(std::max_align_t), "Over aligned pass callbacks are not supported");
+
+		PassData& pass = NewPass(name);
+
+		void* object = AllocateCallback(sizeof(Function), alignof(Function));
+		pass.execute.object = new (object) Function(std::forward<ExecuteFunction>(execute));
+		pass.execute.invoke = [](void* object, RenderGraph& graph) { (*static_cast<Function*>(object))(graph); };
+		pass.execute.destroy = [](void* object) noexcept { static_cast<Function*>(object)->~Function(); };
+
+		PassBuilder builder(*this, pass);
+		setup(builder);
+	}
+}
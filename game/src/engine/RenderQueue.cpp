@@ -0,0 +1,209 @@
+#include "RenderQueue.hpp"
+
+#include "texture.hpp"
+#include "mesh.hpp"
+#include "ogl/StateCacheOGL.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace FoxEngine
+{
+	static constexpr int PassBits = 4;
+	static constexpr int CullBits = 1;
+	static constexpr int IdBits = 12;
+	static constexpr int DepthBits = 23;
+
+	static_assert(PassBits + CullBits + IdBits * 3 + DepthBits == 64, "Draw key must use exactly 64 bits");
+
+	static constexpr int DepthShift = 0;
+	static constexpr int MeshShift = DepthShift + DepthBits;
+	static constexpr int TextureShift = MeshShift + IdBits;
+	static constexpr int ShaderShift = TextureShift + IdBits;
+	static constexpr int CullShift = ShaderShift + IdBits;
+	static constexpr int PassShift = CullShift + CullBits;
+
+	static constexpr std::uint64_t MaxId = (1ull << IdBits) - 1;
+
+	// The bit pattern of a non negative float orders the same as its value, the top bits of it are a
+	// quantized depth that needs no near and far range
+	static std::uint64_t QuantizeDepth(float depth)
+	{
+		if (!(depth > 0.0f)) return 0; // Also catches nan
+
+		return std::bit_cast<std::uint32_t>(depth) >> (31 - DepthBits);
+	}
+
+	RenderQueue::RenderQueue()
+	{
+		mInstanceBuffer = Buffer::Create(
+			{
+				.type = Buffer::Type::Vertex,
+				.usage = Buffer::Usage::Stream,
+				.debugName = "Instance data"
+			});
+	}
+
+	RenderQueue::~RenderQueue() noexcept = default;
+
+	void RenderQueue::Clear()
+	{
+		mItems.clear();
+		mEntries.clear();
+		mShaderIds.clear();
+		mTextureIds.clear();
+		mMeshIds.clear();
+	}
+
+	std::uint64_t RenderQueue::IdOf(std::unordered_map<const void*, std::uint64_t>& ids, const void* resource)
+	{
+		// Past the limit resources share the last id, draws are still correct but no longer grouped
+		auto [it, inserted] = ids.try_emplace(resource, std::min<std::uint64_t>(ids.size(), MaxId));
+		return it->second;
+	}
+
+	void RenderQueue::Submit(Pass pass, Shader& shader, Texture* texture, Mesh& mesh, const glm::mat4& model, float depth)
+	{
+		bool cullsBackFaces = shader.CullsBackFaces();
+
+		std::uint64_t key = 0;
+		key |= static_cast<std::uint64_t>(pass) << PassShift;
+		key |= static_cast<std::uint64_t>(!cullsBackFaces) << CullShift;
+		key |= IdOf(mShaderIds, &shader) << ShaderShift;
+		key |= IdOf(mTextureIds, texture) << TextureShift;
+		key |= IdOf(mMeshIds, &mesh) << MeshShift;
+		key |= QuantizeDepth(depth) << DepthShift;
+
+		mEntries.push_back({ key, static_cast<std::uint32_t>(mItems.size()) });
+		mItems.push_back({ &shader, texture, &mesh, model, cullsBackFaces });
+	}
+
+	void RenderQueue::Sort()
+	{
+		if (mEntries.size() < 2) return;
+
+		mScratch.resize(mEntries.size());
+
+		for (int shift = 0; shift < 64; shift += 8)
+		{
+			std::size_t counts[256]{};
+
+			for (const SortEntry& entry : mEntries)
+				++counts[(entry.key >> shift) & 0xFF];
+
+			// Every key shares this digit, the pass would not change the order
+			if (counts[(mEntries[0].key >> shift) & 0xFF] == mEntries.size())
+				continue;
+
+			std::size_t offset = 0;
+			for (std::size_t& count : counts)
+			{
+				std::size_t next = offset + count;
+				count = offset;
+				offset = next;
+			}
+
+			for (const SortEntry& entry : mEntries)
+				mScratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+
+			mEntries.swap(mScratch);
+		}
+	}
+
+	void RenderQueue::UploadInstances()
+	{
+		mInstanceStaging.resize(mEntries.size());
+
+		for (std::size_t i = 0; i < mEntries.size(); ++i)
+			mInstanceStaging[i] = Shader::InstanceData::Make(mItems[mEntries[i].index].model);
+
+		if (!mInstanceStaging.empty())
+			mInstanceBuffer->Upload(mInstanceStaging.data(), mInstanceStaging.size() * sizeof(Shader::InstanceData));
+	}
+
+	void RenderQueue::Execute()
+	{
+		mStats = {};
+
+		Sort();
+		UploadInstances();
+
+		Shader* shader = nullptr;
+		Texture* texture = nullptr;
+		bool textureBound = false; // Null is a valid binding, it unbinds unit 0
+		Mesh* mesh = nullptr;
+		bool cullsBackFaces = true;
+
+		for (std::size_t first = 0; first < mEntries.size();)
+		{
+			const Item& item = mItems[mEntries[first].index];
+
+			// Everything but depth matches within a run, sorting already put them next to each other
+			std::size_t last = first + 1;
+
+			if (mInstancing)
+			{
+				while (last < mEntries.size())
+				{
+					const Item& next = mItems[mEntries[last].index];
+
+					if (next.shader != item.shader || next.texture != item.texture || next.mesh != item.mesh || next.cullsBackFaces != item.cullsBackFaces)
+						break;
+
+					++last;
+				}
+			}
+
+			if (item.cullsBackFaces != cullsBackFaces)
+			{
+				cullsBackFaces = item.cullsBackFaces;
+				++mStats.cullToggles;
+
+				StateCacheOGL::Get().SetEnabled(GL_CULL_FACE, cullsBackFaces);
+			}
+
+			if (item.shader != shader)
+			{
+				shader = item.shader;
+				shader->Bind();
+				++mStats.shaderBinds;
+			}
+
+			// Whatever the previous draw left bound must not leak into draws without a texture
+			if (Texture* wanted = item.texture ? item.texture : mDefaultTexture; !textureBound || wanted != texture)
+			{
+				texture = wanted;
+				textureBound = true;
+
+				if (texture)
+					texture->Bind();
+				else
+					StateCacheOGL::Get().BindTexture(0, GL_TEXTURE_2D, 0);
+
+				++mStats.textureBinds;
+			}
+
+			if (item.mesh != mesh)
+			{
+				mesh = item.mesh;
+				mesh->Bind();
+				++mStats.meshBinds;
+			}
+
+			unsigned int count = static_cast<unsigned int>(last - first);
+
+			mesh->BindInstances(*mInstanceBuffer, first * sizeof(Shader::InstanceData));
+			mesh->DrawBoundInstanced(count);
+
+			++mStats.draws;
+			mStats.instances += count;
+
+			first = last;
+		}
+
+		if (!cullsBackFaces)
+			StateCacheOGL::Get().Enable(GL_CULL_FACE);
+	}
+}
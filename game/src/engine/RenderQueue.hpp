@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "shader.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace FoxEngine
+{
+	class Texture;
+	class Mesh;
+
+	// Collects the draws of a frame, sorts them by state and submits them with as few binds as possible
+	//
+	// Draws are ordered by a 64-bit key, most significant first:
+	//   pass (4) | cull mode (1) | shader (12) | texture (12) | mesh (12) | depth (23)
+	// Resources get small ids in the order they are first submitted each frame, so equal state ends up adjacent.
+	// Depth sorts front to back within equal state, which helps early depth rejection
+	//
+	// After sorting, runs of draws sharing cull mode, shader, texture and mesh are drawn as one instanced draw call.
+	// Instance data (Shader::InstanceData) for all draws is uploaded at once, the camera block is up to the caller
+	class RenderQueue final
+	{
+	public:
+		// Lower passes are drawn first
+		enum struct Pass : std::uint8_t
+		{
+			Opaque
+		};
+
+		struct Stats final
+		{
+			unsigned int draws = 0; // Draw calls
+			unsigned int instances = 0;
+			unsigned int shaderBinds = 0;
+			unsigned int textureBinds = 0;
+			unsigned int meshBinds = 0;
+			unsigned int cullToggles = 0;
+
+			unsigned int StateChanges() const noexcept { return shaderBinds + textureBinds + meshBinds + cullToggles; }
+		};
+	public:
+		RenderQueue();
+		~RenderQueue() noexcept;
+		RenderQueue(const RenderQueue&) = delete;
+		RenderQueue& operator=(const RenderQueue&) = delete;
+		RenderQueue(RenderQueue&&) noexcept = delete;
+		RenderQueue& operator=(RenderQueue&&) noexcept = delete;
+
+		void Clear();
+
+		// Texture may be null, see SetDefaultTexture. Depth is the view space distance, negative values are treated as zero
+		void Submit(Pass pass, Shader& shader, Texture* texture, Mesh& mesh, const glm::mat4& model, float depth);
+
+		// Sorts and draws everything submitted since the last Clear, expects back face culling to be enabled and leaves it enabled
+		void Execute();
+
+		std::size_t Size() const noexcept { return mItems.size(); }
+
+		// Bound for draws submitted without a texture, unit 0 is unbound for them when this is null too
+		void SetDefaultTexture(Texture* texture) noexcept { mDefaultTexture = texture; }
+
+		// When disabled every submission is its own draw call, kept for comparison
+		void SetInstancing(bool enabled) noexcept { mInstancing = enabled; }
+		bool Instancing() const noexcept { return mInstancing; }
+
+		// Counters of the last Execute
+		const Stats& GetStats() const noexcept { return mStats; }
+	private:
+		struct Item final
+		{
+			Shader* shader;
+			Texture* texture;
+			Mesh* mesh;
+			glm::mat4 model;
+			bool cullsBackFaces;
+		};
+
+		struct SortEntry final
+		{
+			std::uint64_t key;
+			std::uint32_t index;
+		};
+
+		std::uint64_t IdOf(std::unordered_map<const void*, std::uint64_t>& ids, const void* resource);
+
+		// Lsd radix sort on the keys, 8 bits per pass. Passes where every key has the same digit are skipped
+		void Sort();
+
+		void UploadInstances();
+	private:
+		std::vector<Item> mItems;
+		std::vector<SortEntry> mEntries;
+		std::vector<SortEntry> mScratch;
+
+		std::unordered_map<const void*, std::uint64_t> mShaderIds;
+		std::unordered_map<const void*, std::uint64_t> mTextureIds;
+		std::unordered_map<const void*, std::uint64_t> mMeshIds;
+
+		std::unique_ptr<Buffer> mInstanceBuffer;
+		std::vector<Shader::InstanceData> mInstanceStaging;
+
+		Texture* mDefaultTexture = nullptr;
+
+		Stats mStats;
+		bool mInstancing = true;
+	};
+}
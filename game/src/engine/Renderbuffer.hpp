@@ -70,7 +70,7 @@ namespace FoxEngine
 		unsigned int mHandle = 0;
 	};
 
-	FoxEngine::Poly<Renderbuffer> Renderbuffer::Create(const CreateInfo& info)
+	inline FoxEngine::Poly<Renderbuffer> Renderbuffer::Create(const CreateInfo& info)
 	{
 		return Poly<Renderbuffer>(NullOf<RenderbufferOGL33>, info);
 	}
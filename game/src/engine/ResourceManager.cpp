@@ -0,0 +1,427 @@
+#include "ResourceManager.hpp"
+
+#include "CpuProfiler.hpp"
+#include "MeshLoader.hpp"
+#include "Image.hpp"
+#include "blob.hpp"
+#include "log.hpp"
+
+#include <exception>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace FoxEngine
+{
+	static std::shared_ptr<Mesh> CreateMesh(const std::optional<MeshData>& data, std::string_view resource)
+	{
+		if (!data) return nullptr;
+
+		return Mesh::Create(
+			{
+				.vertices = data->Vertices(),
+				.indices = data->Indices(),
+				.debugName = resource
+			});
+	}
+
+	struct ShaderVariant final
+	{
+		std::vector<std::string> keywords;
+		std::string key; // Cache key, the resource alone for the default variant
+		std::string debugName;
+	};
+
+	static ShaderVariant MakeShaderVariant(std::string_view resource, std::string_view keywords)
+	{
+		ShaderVariant variant{ Shader::ParseKeywords(keywords), std::string(resource), std::string(resource) };
+
+		if (!variant.keywords.empty())
+		{
+			// The whole normalized set, a hash of it could collide and hand one variant's program to another
+			std::string joined = Shader::JoinKeywords(variant.keywords);
+
+			variant.key += '#';
+			variant.key += joined;
+
+			variant.debugName += " [";
+			variant.debugName += joined;
+			variant.debugName += ']';
+		}
+
+		return variant;
+	}
+
+	// Drawn in place of shaders that are still compiling, uses the same engine blocks as the mesh shaders
+	static constexpr std::string_view FallbackShaderSource = R"(
+input(vec3, inPosition, 0);
+input(vec3, inNormal, 1);
+
+output(vec4, outColor, 0);
+output(vec4, outBlack, 1);
+
+varying(vec3, vNormal);
+
+#ifdef FE_VERT
+void main(void)
+{
+	gl_Position = feViewProjection * feModel * vec4(inPosition, 1.0);
+	vNormal = feNormalMatrix * inNormal;
+}
+#elif defined FE_FRAG
+void main(void)
+{
+	outColor = vec4(vec3(0.35 + 0.25 * normalize(vNormal).y), 1.0);
+	outBlack = vec4(0.0, 0.0, 0.0, 1.0);
+}
+#endif
+)";
+
+	static std::shared_ptr<Shader> CreateShader(const ShaderVariant& variant, std::string_view resource, std::string_view source)
+	{
+		try
+		{
+			return Shader::Create(
+				{
+					.filename = resource,
+					.source = source,
+					.debugName = variant.debugName,
+					.keywords = variant.keywords,
+					.async = true
+				}).MakeUnique();
+		}
+		catch (const std::exception& e)
+		{
+			Log::Error("Failed to create shader {}: {}", variant.debugName, e.what());
+			return nullptr;
+		}
+	}
+
+	ResourceManager::ResourceManager() = default;
+
+	ResourceManager::~ResourceManager() noexcept
+	{
+		// Unblocks workers waiting on a full queue, the pool joins them afterwards
+		mUploads.Close();
+	}
+
+	template<class T>
+	ResourceFuture<T> ResourceManager::MakeReady(std::shared_ptr<T> value)
+	{
+		std::promise<std::shared_ptr<T>> promise;
+		promise.set_value(std::move(value));
+		return promise.get_future().share();
+	}
+
+	template<class T>
+	std::shared_ptr<T> ResourceManager::Wait(const ResourceFuture<T>& future)
+	{
+		while (!IsReady(future))
+		{
+			std::function<void()> upload;
+
+			PollShaders();
+
+			if (mUploads.TryPop(upload))
+				upload();
+			else
+				std::this_thread::yield();
+		}
+
+		return future.get();
+	}
+
+	std::shared_ptr<Mesh> ResourceManager::GetMesh(std::string_view resource)
+	{
+		auto it = mMeshes.find(resource);
+
+		if (it != mMeshes.end())
+			if (std::shared_ptr<Mesh> ref = it->second.lock())
+				return ref;
+
+		if (auto pending = mPendingMeshes.find(resource); pending != mPendingMeshes.end())
+			return Wait(ResourceFuture<Mesh>(pending->second));
+
+		Log::Info("Loading mesh: {}", resource);
+
+		std::shared_ptr<Mesh> ref = CreateMesh(MeshLoader::Decode(resource), resource);
+		mMeshes[std::string(resource)] = ref;
+		return ref;
+	}
+
+	std::shared_ptr<Shader> ResourceManager::GetShader(std::string_view resource, std::string_view keywords)
+	{
+		ShaderVariant variant = MakeShaderVariant(resource, keywords);
+
+		auto it = mShaders.find(variant.key);
+
+		if (it != mShaders.end())
+			if (std::shared_ptr<Shader> ref = it->second.lock())
+				return ref;
+
+		if (auto pending = mPendingShaders.find(variant.key); pending != mPendingShaders.end())
+			return Wait(ResourceFuture<Shader>(pending->second));
+
+		Log::Info("Loading shader: {}", variant.debugName);
+
+		std::shared_ptr<Shader> ref = Shader::Create(
+			{
+				.filename = resource,
+				.debugName = variant.debugName,
+				.keywords = variant.keywords
+			}).MakeUnique();
+
+		mShaders[variant.key] = ref;
+		return ref;
+	}
+
+	ResourceFuture<Mesh> ResourceManager::GetMeshAsync(std::string_view resource)
+	{
+		auto it = mMeshes.find(resource);
+
+		if (it != mMeshes.end())
+			if (std::shared_ptr<Mesh> ref = it->second.lock())
+				return MakeReady(std::move(ref));
+
+		if (auto pending = mPendingMeshes.find(resource); pending != mPendingMeshes.end())
+			return pending->second;
+
+		Log::Info("Loading mesh (async): {}", resource);
+
+		auto promise = std::make_shared<std::promise<std::shared_ptr<Mesh>>>();
+		ResourceFuture<Mesh> future = promise->get_future().share();
+		mPendingMeshes.emplace(std::string(resource), future);
+
+		mPool.Submit([this, name = std::string(resource), promise]
+			{
+				auto data = std::make_shared<std::optional<MeshData>>(MeshLoader::Decode(name));
+
+				mUploads.Push([this, name, promise, data]
+					{
+						std::shared_ptr<Mesh> ref = CreateMesh(*data, name);
+						mMeshes[name] = ref;
+						mPendingMeshes.erase(name);
+						promise->set_value(std::move(ref));
+					});
+			});
+
+		return future;
+	}
+
+	ResourceFuture<Shader> ResourceManager::GetShaderAsync(std::string_view resource, std::string_view keywords)
+	{
+		auto variant = std::make_shared<ShaderVariant>(MakeShaderVariant(resource, keywords));
+
+		auto it = mShaders.find(variant->key);
+
+		if (it != mShaders.end())
+			if (std::shared_ptr<Shader> ref = it->second.lock())
+				return MakeReady(std::move(ref));
+
+		if (auto pending = mPendingShaders.find(variant->key); pending != mPendingShaders.end())
+			return pending->second;
+
+		Log::Info("Loading shader (async): {}", variant->debugName);
+
+		auto promise = std::make_shared<std::promise<std::shared_ptr<Shader>>>();
+		ResourceFuture<Shader> future = promise->get_future().share();
+		mPendingShaders.emplace(variant->key, future);
+
+		mPool.Submit([this, name = std::string(resource), variant, promise]
+			{
+				FE_PROFILE_SCOPE("Read shader source");
+
+				// The mapping itself is handed to the compile, the source is never copied out of the page cache
+				auto source = std::make_shared<Blob>();
+
+				try
+				{
+					*source = Blob::MapFile(name);
+				}
+				catch (const Exception::FileRead& e)
+				{
+					Log::Error("Failed to read shader {}: {}", name, e.what());
+				}
+
+				mUploads.Push([this, name, variant, promise, source]
+					{
+						std::shared_ptr<Shader> ref;
+
+						if (*source)
+							ref = CreateShader(*variant, name, source->string());
+
+						// Resolved by PollShaders once the driver is done
+						if (ref)
+						{
+							mCompilingShaders.push_back({ std::move(ref), variant->key, variant->debugName, promise });
+							return;
+						}
+
+						mShaders[variant->key] = ref;
+						mPendingShaders.erase(variant->key);
+						promise->set_value(std::move(ref));
+					});
+			});
+
+		return future;
+	}
+
+	std::shared_ptr<Texture> ResourceManager::CreateTexture(const Image& image, std::string_view resource)
+	{
+		std::size_t bytes = static_cast<std::size_t>(image.Width()) * image.Height() * 4;
+
+		Texture* texture = Texture::Create(image, resource).MakeUnique().release();
+
+		mTextureStats->residentBytes += bytes;
+		++mTextureStats->residentCount;
+
+		return std::shared_ptr<Texture>(texture, [stats = mTextureStats, bytes](Texture* texture)
+			{
+				stats->residentBytes -= bytes;
+				--stats->residentCount;
+				delete texture;
+			});
+	}
+
+	std::shared_ptr<Texture> ResourceManager::GetTexture(std::string_view resource)
+	{
+		auto it = mTextures.find(resource);
+
+		if (it != mTextures.end())
+		{
+			if (std::shared_ptr<Texture> ref = it->second.lock())
+			{
+				++mTextureStats->hits;
+				return ref;
+			}
+		}
+
+		if (auto pending = mPendingTextures.find(resource); pending != mPendingTextures.end())
+		{
+			++mTextureStats->hits;
+			return Wait(ResourceFuture<Texture>(pending->second));
+		}
+
+		++mTextureStats->misses;
+
+		Log::Info("Loading texture: {}", resource);
+
+		std::shared_ptr<Texture> ref;
+
+		if (Image image = Image::FromFile(resource))
+			ref = CreateTexture(image, resource);
+		else
+			Log::Error("Failed to decode texture: {}", resource);
+
+		mTextures[std::string(resource)] = ref;
+		return ref;
+	}
+
+	ResourceFuture<Texture> ResourceManager::GetTextureAsync(std::string_view resource)
+	{
+		auto it = mTextures.find(resource);
+
+		if (it != mTextures.end())
+		{
+			if (std::shared_ptr<Texture> ref = it->second.lock())
+			{
+				++mTextureStats->hits;
+				return MakeReady(std::move(ref));
+			}
+		}
+
+		if (auto pending = mPendingTextures.find(resource); pending != mPendingTextures.end())
+		{
+			++mTextureStats->hits;
+			return pending->second;
+		}
+
+		++mTextureStats->misses;
+
+		Log::Info("Loading texture (async): {}", resource);
+
+		auto promise = std::make_shared<std::promise<std::shared_ptr<Texture>>>();
+		ResourceFuture<Texture> future = promise->get_future().share();
+		mPendingTextures.emplace(std::string(resource), future);
+
+		mPool.Submit([this, name = std::string(resource), promise]
+			{
+				auto image = std::make_shared<Image>(Image::FromFile(name));
+
+				if (!*image)
+					Log::Error("Failed to decode texture: {}", name);
+
+				mUploads.Push([this, name, promise, image]
+					{
+						std::shared_ptr<Texture> ref;
+
+						if (*image)
+							ref = CreateTexture(*image, name);
+
+						mTextures[name] = ref;
+						mPendingTextures.erase(name);
+						promise->set_value(std::move(ref));
+					});
+			});
+
+		return future;
+	}
+
+	std::shared_ptr<Shader> ResourceManager::FallbackShader()
+	{
+		if (!mFallbackShader)
+		{
+			mFallbackShader = Shader::Create(
+				{
+					.filename = "(fallback)",
+					.source = FallbackShaderSource,
+					.debugName = "Fallback shader"
+				}).MakeUnique();
+		}
+
+		return mFallbackShader;
+	}
+
+	void ResourceManager::PollShaders()
+	{
+		std::erase_if(mCompilingShaders, [this](CompilingShader& compiling)
+			{
+				std::shared_ptr<Shader> ref = compiling.shader;
+
+				try
+				{
+					if (!ref->IsReady()) return false;
+				}
+				catch (const std::exception& e)
+				{
+					Log::Error("Failed to create shader {}: {}", compiling.debugName, e.what());
+					ref = nullptr;
+				}
+
+				mShaders[compiling.key] = ref;
+				mPendingShaders.erase(compiling.key);
+				compiling.promise->set_value(std::move(ref));
+				return true;
+			});
+	}
+
+	void ResourceManager::Update(std::chrono::microseconds budget)
+	{
+		FE_PROFILE_SCOPE("Resource loading");
+
+		auto start = std::chrono::steady_clock::now();
+
+		PollShaders();
+
+		std::function<void()> upload;
+
+		while (mUploads.TryPop(upload))
+		{
+			upload();
+
+			if (std::chrono::steady_clock::now() - start >= budget)
+				break;
+		}
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+#include "UnorderedMapString.hpp"
+#include "ThreadPool.hpp"
+#include "BoundedQueue.hpp"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace FoxEngine
+{
+	class Image;
+
+	// Resolves to nullptr if the resource failed to load
+	template<class T>
+	using ResourceFuture = std::shared_future<std::shared_ptr<T>>;
+
+	template<class T>
+	bool IsReady(const ResourceFuture<T>& future)
+	{
+		return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	struct CacheStats final
+	{
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		std::size_t residentCount = 0;
+		std::size_t residentBytes = 0; // Estimated from the uploaded pixel data
+	};
+
+	// Resources are cached weakly, they are unloaded once nothing references them anymore
+	//
+	// The async api runs file io and decoding on a worker pool, the gpu objects are then created
+	// on the thread calling Update. Async shaders are compiled without blocking and resolve on a later
+	// Update once the driver is done. All functions must be called from the thread owning the gl context
+	class ResourceManager final
+	{
+	public:
+		ResourceManager();
+		~ResourceManager() noexcept;
+		ResourceManager(const ResourceManager&) = delete;
+		ResourceManager& operator=(const ResourceManager&) = delete;
+		ResourceManager(ResourceManager&&) noexcept = delete;
+		ResourceManager& operator=(ResourceManager&&) noexcept = delete;
+
+		// Blocking loads, these join an in flight async load of the same resource
+		// Shader keywords select a variant, see Shader::ParseKeywords. Each variant is compiled the first time it is requested
+		std::shared_ptr<Mesh> GetMesh(std::string_view resource);
+		std::shared_ptr<Shader> GetShader(std::string_view resource, std::string_view keywords = {});
+		std::shared_ptr<Texture> GetTexture(std::string_view resource);
+
+		// Requests for a resource that is already loading share the same future
+		ResourceFuture<Mesh> GetMeshAsync(std::string_view resource);
+		ResourceFuture<Shader> GetShaderAsync(std::string_view resource, std::string_view keywords = {});
+		ResourceFuture<Texture> GetTextureAsync(std::string_view resource);
+
+		// Runs queued gpu uploads until the budget is spent, at least one upload is always run
+		void Update(std::chrono::microseconds budget);
+
+		std::size_t PendingUploads() { return mUploads.Size(); }
+		std::size_t CompilingShaders() const noexcept { return mCompilingShaders.size(); }
+
+		// Plain shaded stand in for meshes whose shader is still loading, created on first use
+		std::shared_ptr<Shader> FallbackShader();
+
+		const CacheStats& TextureStats() const noexcept { return *mTextureStats; }
+	private:
+		// The returned texture keeps the resident counters up to date when it is destroyed
+		std::shared_ptr<Texture> CreateTexture(const Image& image, std::string_view resource);
+
+		template<class T>
+		static ResourceFuture<T> MakeReady(std::shared_ptr<T> value);
+
+		// Resolves async shaders the driver has finished compiling
+		void PollShaders();
+
+		// Drains uploads until the future resolves, used when a blocking call hits an in flight load
+		template<class T>
+		std::shared_ptr<T> Wait(const ResourceFuture<T>& future);
+	private:
+		UnorderedStringMap<std::weak_ptr<Mesh>> mMeshes;
+		UnorderedStringMap<std::weak_ptr<Shader>> mShaders;
+		UnorderedStringMap<std::weak_ptr<Texture>> mTextures;
+
+		UnorderedStringMap<ResourceFuture<Mesh>> mPendingMeshes;
+		UnorderedStringMap<ResourceFuture<Shader>> mPendingShaders;
+		UnorderedStringMap<ResourceFuture<Texture>> mPendingTextures;
+
+		struct CompilingShader final
+		{
+			std::shared_ptr<Shader> shader;
+			std::string key;
+			std::string debugName;
+			std::shared_ptr<std::promise<std::shared_ptr<Shader>>> promise;
+		};
+
+		std::vector<CompilingShader> mCompilingShaders;
+		std::shared_ptr<Shader> mFallbackShader;
+
+		// Shared with the texture deleters, textures may outlive the manager
+		std::shared_ptr<CacheStats> mTextureStats = std::make_shared<CacheStats>();
+
+		// Workers block once this is full, which keeps decoded data from piling up in memory
+		BoundedQueue<std::function<void()>> mUploads{ 16 };
+
+		// Must be destroyed first so no worker touches the members above during destruction
+		ThreadPool mPool;
+	};
+}
@@ -0,0 +1,273 @@
+#include "ShaderPreprocessor.hpp"
+
+#include "blob.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <unordered_set>
+#include <vector>
+
+namespace FoxEngine
+{
+	namespace
+	{
+		using IncludeSet = std::unordered_set<std::string>;
+
+		struct Context final
+		{
+			ShaderPreprocessor::Result& result;
+			IncludeSet included = {}; // Files already pasted on the path through the conditionals taken so far
+			std::vector<std::string> open = {}; // Files being processed, innermost last
+		};
+
+		// A #if block, each branch starts from the files included before it
+		struct Conditional final
+		{
+			IncludeSet entry = {};
+			IncludeSet common = {}; // Included by every branch closed so far
+			bool closedBranch = false;
+			bool hasElse = false;
+		};
+
+		bool IsIdentifierChar(char c)
+		{
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+		}
+
+		void SkipSpace(std::string_view& string)
+		{
+			std::size_t i = 0;
+			while (i < string.size() && (string[i] == ' ' || string[i] == '\t' || string[i] == '\r')) ++i;
+			string.remove_prefix(i);
+		}
+
+		std::string_view ReadIdentifier(std::string_view& string)
+		{
+			std::size_t i = 0;
+			while (i < string.size() && IsIdentifierChar(string[i])) ++i;
+
+			std::string_view identifier = string.substr(0, i);
+			string.remove_prefix(i);
+			return identifier;
+		}
+
+		// Accepts "path" or <path>, returns an empty view on malformed input
+		std::string_view ReadPath(std::string_view& string)
+		{
+			if (string.empty()) return {};
+
+			char close = string[0] == '"' ? '"' : string[0] == '<' ? '>' : 0;
+			if (!close) return {};
+
+			std::size_t end = string.find(close, 1);
+			if (end == std::string_view::npos) return {};
+
+			std::string_view path = string.substr(1, end - 1);
+			string.remove_prefix(end + 1);
+			return path;
+		}
+
+		// Only whitespace, a ';' or a line comment may follow a directive
+		bool IsEndOfDirective(std::string_view string)
+		{
+			SkipSpace(string);
+			if (!string.empty() && string[0] == ';') string.remove_prefix(1);
+			SkipSpace(string);
+			return string.empty() || string.starts_with("//");
+		}
+
+		// Tracks /* */ comments so directives inside them are left alone
+		bool UpdateBlockComment(std::string_view line, bool inBlockComment)
+		{
+			for (std::size_t i = 0; i + 1 < line.size(); ++i)
+			{
+				if (inBlockComment)
+				{
+					if (line[i] == '*' && line[i + 1] == '/')
+					{
+						inBlockComment = false;
+						++i;
+					}
+				}
+				else if (line[i] == '/')
+				{
+					if (line[i + 1] == '/') break;
+
+					if (line[i + 1] == '*')
+					{
+						inBlockComment = true;
+						++i;
+					}
+				}
+			}
+
+			return inBlockComment;
+		}
+
+		void IntersectInto(IncludeSet& common, const IncludeSet& branch, bool first)
+		{
+			if (first)
+			{
+				common = branch;
+				return;
+			}
+
+			std::erase_if(common, [&](const std::string& path) { return !branch.contains(path); });
+		}
+
+		// Keeps the include once set scoped to the branches of #if blocks, a chunk included in one branch
+		// is still pasted in the next. After #endif only chunks every branch included count, without an
+		// #else the skipped case includes nothing so the set goes back to what it was before the block
+		void TrackConditional(Context& context, std::vector<Conditional>& conditionals, std::string_view directive)
+		{
+			if (directive == "if" || directive == "ifdef" || directive == "ifndef")
+			{
+				conditionals.push_back({ .entry = context.included });
+				return;
+			}
+
+			// Unbalanced within this file, left for the glsl compiler to report
+			if (conditionals.empty())
+				return;
+
+			Conditional& conditional = conditionals.back();
+
+			if (directive == "elif" || directive == "else")
+			{
+				IntersectInto(conditional.common, context.included, !conditional.closedBranch);
+				conditional.closedBranch = true;
+				conditional.hasElse |= directive == "else";
+				context.included = conditional.entry;
+			}
+			else if (directive == "endif")
+			{
+				if (conditional.hasElse)
+				{
+					IntersectInto(conditional.common, context.included, false);
+					context.included = std::move(conditional.common);
+				}
+				else
+				{
+					context.included = std::move(conditional.entry);
+				}
+
+				conditionals.pop_back();
+			}
+		}
+
+		std::string NormalizePath(const std::filesystem::path& path)
+		{
+			return path.lexically_normal().generic_string();
+		}
+
+		void ProcessFile(Context& context, std::string_view filename, std::string_view source, std::size_t fileIndex)
+		{
+			std::string& out = context.result.source;
+			out.reserve(out.size() + source.size());
+
+			bool inBlockComment = false;
+			std::size_t lineNumber = 0;
+			std::vector<Conditional> conditionals;
+
+			while (!source.empty())
+			{
+				std::size_t end = source.find('\n');
+				std::string_view line = source.substr(0, end);
+				source.remove_prefix(end == std::string_view::npos ? source.size() : end + 1);
+				++lineNumber;
+
+				std::string_view cursor = line;
+				SkipSpace(cursor);
+
+				if (inBlockComment || cursor.empty() || cursor[0] != '@')
+				{
+					if (!inBlockComment && !cursor.empty() && cursor[0] == '#')
+					{
+						cursor.remove_prefix(1);
+						SkipSpace(cursor);
+						TrackConditional(context, conditionals, ReadIdentifier(cursor));
+					}
+
+					inBlockComment = UpdateBlockComment(line, inBlockComment);
+					out += line;
+					out += '\n';
+					continue;
+				}
+
+				// Directive lines are commented out rather than removed so line numbers stay the same
+				out += "// (FoxEngine Preprocess) -> ";
+				out += line;
+				out += '\n';
+
+				cursor.remove_prefix(1);
+				std::string_view directive = ReadIdentifier(cursor);
+				SkipSpace(cursor);
+
+				if (directive == "pragma")
+				{
+					std::string_view pragma = ReadIdentifier(cursor);
+
+					if (pragma.empty() || !IsEndOfDirective(cursor))
+						Log::Warn("{}({}): malformed shader pragma", filename, lineNumber);
+					else if (pragma == "backface_nocull")
+						context.result.cullsBackFaces = false;
+					else
+						Log::Warn("{}({}): unknown shader pragma: {}", filename, lineNumber, pragma);
+				}
+				else if (directive == "include")
+				{
+					std::string_view includeName = ReadPath(cursor);
+
+					if (includeName.empty() || !IsEndOfDirective(cursor))
+					{
+						Log::Warn("{}({}): malformed shader include", filename, lineNumber);
+						continue;
+					}
+
+					std::string path = NormalizePath(std::filesystem::path(filename).parent_path() / includeName);
+
+					if (std::find(context.open.begin(), context.open.end(), path) != context.open.end())
+					{
+						Log::Warn("{}({}): shader include cycle: {}", filename, lineNumber, path);
+						continue;
+					}
+
+					// Implicit include guard for the branch being processed
+					if (!context.included.insert(path).second)
+						continue;
+
+					Blob blob = Blob::MapFile(path);
+
+					std::size_t includeIndex = context.result.files.size();
+					context.result.files.push_back(path);
+
+					out += Log::FormatArgs("#line 1 {}\n", includeIndex);
+					context.open.push_back(path);
+					ProcessFile(context, path, blob.string(), includeIndex);
+					context.open.pop_back();
+					out += Log::FormatArgs("#line {} {}\n", lineNumber + 1, fileIndex);
+				}
+				else
+				{
+					Log::Warn("{}({}): unknown shader directive: @{}", filename, lineNumber, directive);
+				}
+			}
+		}
+	}
+
+	ShaderPreprocessor::Result ShaderPreprocessor::Process(std::string_view filename, std::string_view source)
+	{
+		Result result;
+		Context context{ result };
+
+		std::string path = NormalizePath(filename);
+		context.included.insert(path);
+		context.open.push_back(path);
+		result.files.push_back(path);
+
+		ProcessFile(context, path, source, 0);
+
+		return result;
+	}
+}
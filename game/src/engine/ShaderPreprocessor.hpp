@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Engine level shader directives, resolved before the source reaches the driver
+//
+// @pragma backface_nocull     Disables backface culling for the shader
+// @include "file.glsl"        Pastes a shared chunk, paths are relative to the including file
+//
+// Directives must start a line and may end with an optional ';'. A file is included at most once along
+// each path through #if/#elif/#else, so chunks need no include guards of their own and a chunk used by
+// both the FE_VERT and FE_FRAG branches reaches both. Include cycles are skipped with a warning.
+// Line numbers are kept intact with #line, every file gets its own source string number which is
+// the index into Result::files
+
+namespace FoxEngine
+{
+	class ShaderPreprocessor final
+	{
+	public:
+		struct Result final
+		{
+			std::string source;
+			std::vector<std::string> files;
+			bool cullsBackFaces = true;
+		};
+
+		// Throws Exception::FileRead if an included file can't be read
+		static Result Process(std::string_view filename, std::string_view source);
+	};
+}
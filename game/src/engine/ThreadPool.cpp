@@ -0,0 +1,75 @@
+#include "ThreadPool.hpp"
+
+#include "CpuProfiler.hpp"
+#include "log.hpp"
+
+#include <algorithm>
+#include <exception>
+
+namespace FoxEngine
+{
+	ThreadPool::ThreadPool(unsigned int threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		mThreads.reserve(threadCount);
+
+		for (unsigned int i = 0; i < threadCount; ++i)
+			mThreads.emplace_back(&ThreadPool::WorkerMain, this);
+	}
+
+	ThreadPool::~ThreadPool() noexcept
+	{
+		{
+			std::lock_guard lock{ mMutex };
+			mStopping = true;
+			mJobs.clear();
+		}
+
+		mCondition.notify_all();
+
+		for (std::thread& thread : mThreads)
+			thread.join();
+	}
+
+	void ThreadPool::Submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard lock{ mMutex };
+			mJobs.push_back(std::move(job));
+		}
+
+		mCondition.notify_one();
+	}
+
+	void ThreadPool::WorkerMain()
+	{
+		FE_PROFILE_THREAD("Worker");
+
+		for (;;)
+		{
+			std::function<void()> job;
+
+			{
+				std::unique_lock lock{ mMutex };
+				mCondition.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+
+				if (mStopping) return;
+
+				job = std::move(mJobs.front());
+				mJobs.pop_front();
+			}
+
+			// A throwing job must not take the worker down with it
+			try
+			{
+				job();
+			}
+			catch (const std::exception& e)
+			{
+				Log::Error("Unhandled exception in worker job: {}", e.what());
+			}
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FoxEngine
+{
+	// Fixed size pool of worker threads pulling jobs from a shared fifo
+	class ThreadPool final
+	{
+	public:
+		// Zero picks one less than the hardware thread count, leaving room for the main thread
+		explicit ThreadPool(unsigned int threadCount = 0);
+
+		// Jobs that haven't started yet are dropped, running jobs are waited on
+		~ThreadPool() noexcept;
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		void Submit(std::function<void()> job);
+
+		std::size_t ThreadCount() const noexcept { return mThreads.size(); }
+	private:
+		void WorkerMain();
+	private:
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::deque<std::function<void()>> mJobs;
+		bool mStopping = false;
+		std::vector<std::thread> mThreads;
+	};
+}
@@ -0,0 +1,156 @@
+#include "TransformBatch.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+namespace FoxEngine
+{
+	static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "Matrices are written as 16 packed floats");
+
+	void TransformBatch::Clear()
+	{
+		mSize = 0;
+	}
+
+	void TransformBatch::Add(const glm::vec3& translation, const glm::quat& orientation, const glm::vec3& scale)
+	{
+		// Same padding scheme as CullingBatch, the padding lanes are composed but never written out
+		if (mSize % Width == 0)
+		{
+			std::size_t padded = mSize + Width;
+
+			for (std::vector<float>* array : { &mTranslationX, &mTranslationY, &mTranslationZ, &mRotationX, &mRotationY, &mRotationZ, &mRotationW, &mScaleX, &mScaleY, &mScaleZ })
+				if (array->size() < padded)
+					array->resize(padded);
+		}
+
+		mTranslationX[mSize] = translation.x;
+		mTranslationY[mSize] = translation.y;
+		mTranslationZ[mSize] = translation.z;
+		mRotationX[mSize] = orientation.x;
+		mRotationY[mSize] = orientation.y;
+		mRotationZ[mSize] = orientation.z;
+		mRotationW[mSize] = orientation.w;
+		mScaleX[mSize] = scale.x;
+		mScaleY[mSize] = scale.y;
+		mScaleZ[mSize] = scale.z;
+		++mSize;
+	}
+
+#if defined(__AVX2__)
+	// Row i of the result holds element i of every input register
+	static void Transpose8x8(__m256 rows[8])
+	{
+		__m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+		__m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+		__m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+		__m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+		__m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+		__m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+		__m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+		__m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+		__m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+		__m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+		rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+		rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+		rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+		rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+		rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+		rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+		rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+		rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+	}
+#endif
+
+	void TransformBatch::Compose(glm::mat4* out) const
+	{
+		for (std::size_t base = 0; base < mSize; base += Width)
+		{
+			std::size_t count = std::min(Width, mSize - base);
+
+			// Full groups are written in place, the last partial one goes through a scratch copy
+			glm::mat4 scratch[Width];
+			float* target = reinterpret_cast<float*>(count == Width ? out + base : scratch);
+
+#if defined(__AVX2__)
+			__m256 x = _mm256_loadu_ps(&mRotationX[base]);
+			__m256 y = _mm256_loadu_ps(&mRotationY[base]);
+			__m256 z = _mm256_loadu_ps(&mRotationZ[base]);
+			__m256 w = _mm256_loadu_ps(&mRotationW[base]);
+			__m256 sx = _mm256_loadu_ps(&mScaleX[base]);
+			__m256 sy = _mm256_loadu_ps(&mScaleY[base]);
+			__m256 sz = _mm256_loadu_ps(&mScaleZ[base]);
+
+			__m256 one = _mm256_set1_ps(1.0f);
+			__m256 two = _mm256_set1_ps(2.0f);
+
+			__m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+			__m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+			__m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+			// Element i of a column major matrix, 16 registers of 8 matrices each
+			__m256 elements[16];
+			elements[0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+			elements[1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+			elements[2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+			elements[3] = _mm256_setzero_ps();
+			elements[4] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+			elements[5] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+			elements[6] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+			elements[7] = _mm256_setzero_ps();
+			elements[8] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+			elements[9] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+			elements[10] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+			elements[11] = _mm256_setzero_ps();
+			elements[12] = _mm256_loadu_ps(&mTranslationX[base]);
+			elements[13] = _mm256_loadu_ps(&mTranslationY[base]);
+			elements[14] = _mm256_loadu_ps(&mTranslationZ[base]);
+			elements[15] = one;
+
+			// Two 8x8 transposes turn the registers into the first and second half of each matrix
+			Transpose8x8(elements);
+			Transpose8x8(elements + 8);
+
+			for (std::size_t lane = 0; lane < Width; ++lane)
+			{
+				_mm256_storeu_ps(target + lane * 16, elements[lane]);
+				_mm256_storeu_ps(target + lane * 16 + 8, elements[lane + 8]);
+			}
+#else
+			for (std::size_t lane = 0; lane < Width; ++lane)
+			{
+				std::size_t i = base + lane;
+
+				float x = mRotationX[i], y = mRotationY[i], z = mRotationZ[i], w = mRotationW[i];
+				float sx = mScaleX[i], sy = mScaleY[i], sz = mScaleZ[i];
+
+				float elements[16] =
+				{
+					(1.0f - 2.0f * (y * y + z * z)) * sx, 2.0f * (x * y + w * z) * sx, 2.0f * (x * z - w * y) * sx, 0.0f,
+					2.0f * (x * y - w * z) * sy, (1.0f - 2.0f * (x * x + z * z)) * sy, 2.0f * (y * z + w * x) * sy, 0.0f,
+					2.0f * (x * z + w * y) * sz, 2.0f * (y * z - w * x) * sz, (1.0f - 2.0f * (x * x + y * y)) * sz, 0.0f,
+					mTranslationX[i], mTranslationY[i], mTranslationZ[i], 1.0f
+				};
+
+				std::memcpy(target + lane * 16, elements, sizeof(elements));
+			}
+#endif
+
+			if (count != Width)
+				std::copy(scratch, scratch + count, out + base);
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace FoxEngine
+{
+	// Translation, rotation and scale stored as one packed array per component, padded to a multiple of 8.
+	// Compose builds the matrices 8 at a time, with 256-bit lanes when AVX2 is enabled (release and dist)
+	// and the same loop in scalar code otherwise
+	class TransformBatch final
+	{
+	public:
+		static constexpr std::size_t Width = 8;
+
+		void Clear();
+
+		void Add(const glm::vec3& translation, const glm::quat& orientation, const glm::vec3& scale);
+
+		std::size_t Size() const noexcept { return mSize; }
+
+		// Writes Size() matrices, each equal to translate(translation) * toMat4(orientation) * scale(scale).
+		// The orientations are expected to be normalized
+		void Compose(glm::mat4* out) const;
+	private:
+		std::vector<float> mTranslationX, mTranslationY, mTranslationZ;
+		std::vector<float> mRotationX, mRotationY, mRotationZ, mRotationW;
+		std::vector<float> mScaleX, mScaleY, mScaleZ;
+		std::size_t mSize = 0;
+	};
+}
@@ -2,6 +2,16 @@
 
 #include <utility>
 #include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#	include <Windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
 
 namespace FoxEngine
 {
@@ -10,7 +20,7 @@ namespace FoxEngine
 		std::ifstream in{ filename.data(), std::ios::in | std::ios::binary };
 
 		if (!in) throw Exception::FileRead{ "Failed to load file" };
-		
+
 		in.seekg(0, std::ios::end);
 		Blob blob(in.tellg());
 		in.seekg(0, std::ios::beg);
@@ -20,6 +30,80 @@ namespace FoxEngine
 		return blob;
 	}
 
+#ifdef _WIN32
+	Blob Blob::MapFile(std::string_view filename)
+	{
+		std::string path{ filename };
+
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) throw Exception::FileRead{ "Failed to load file" };
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			throw Exception::FileRead{ "Failed to load file" };
+		}
+
+		// Zero sized mappings are not allowed
+		if (size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return {};
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (!mapping) throw Exception::FileRead{ "Failed to map file" };
+
+		// The view keeps the mapping alive, so the handle can be closed right away
+		void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+		CloseHandle(mapping);
+		if (!view) throw Exception::FileRead{ "Failed to map file" };
+
+		return Blob(static_cast<std::byte*>(view), static_cast<std::size_t>(size.QuadPart), [](std::byte* data, std::size_t) noexcept
+			{
+				UnmapViewOfFile(data);
+			});
+	}
+#else
+	Blob Blob::MapFile(std::string_view filename)
+	{
+		std::string path{ filename };
+
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) throw Exception::FileRead{ "Failed to load file" };
+
+		struct stat info;
+		if (fstat(fd, &info) != 0)
+		{
+			close(fd);
+			throw Exception::FileRead{ "Failed to load file" };
+		}
+
+		// Zero sized mappings are not allowed
+		if (info.st_size == 0)
+		{
+			close(fd);
+			return {};
+		}
+
+		std::size_t size = static_cast<std::size_t>(info.st_size);
+
+		// The mapping holds its own reference to the file, so the descriptor can be closed right away
+		void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (view == MAP_FAILED) throw Exception::FileRead{ "Failed to map file" };
+
+		madvise(view, size, MADV_SEQUENTIAL);
+
+		return Blob(static_cast<std::byte*>(view), size, [](std::byte* data, std::size_t size) noexcept
+			{
+				munmap(data, size);
+			});
+	}
+#endif
+
 	Blob::Blob(std::size_t size)
 	{
 		if (size == 0) return;
@@ -31,9 +115,15 @@ namespace FoxEngine
 	Blob::Blob(std::byte* data, std::size_t size) noexcept
 		: mData(data), mSize(size) {}
 
+	Blob::Blob(std::byte* data, std::size_t size, Deleter deleter) noexcept
+		: mData(data), mSize(size), mDeleter(deleter) {}
+
 	Blob::~Blob() noexcept
 	{
-		delete[] mData;
+		if (mDeleter)
+			mDeleter(mData, mSize);
+		else
+			delete[] mData;
 	}
 
 	Blob::Blob(Blob&& other) noexcept
@@ -52,5 +142,6 @@ namespace FoxEngine
 		using std::swap;
 		swap(lhs.mData, rhs.mData);
 		swap(lhs.mSize, rhs.mSize);
+		swap(lhs.mDeleter, rhs.mDeleter);
 	}
-}
\ No newline at end of file
+}
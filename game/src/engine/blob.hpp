@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <span>
 #include <string_view>
 #include <stdexcept>
 
@@ -20,11 +21,19 @@ namespace FoxEngine
 	class Blob final
 	{
 	public:
+		// Releases the memory owned by a blob, nullptr means the memory came from new[]
+		using Deleter = void(*)(std::byte* data, std::size_t size) noexcept;
+
 		[[nodiscard]] static Blob FromFile(std::string_view filename);
 
+		// Maps the file copy-on-write, reads are served straight from the page cache
+		// and no copy is made until the blob is written to
+		[[nodiscard]] static Blob MapFile(std::string_view filename);
+
 		Blob() noexcept = default;
 		explicit Blob(std::size_t size);
 		Blob(std::byte* data, std::size_t size) noexcept;
+		Blob(std::byte* data, std::size_t size, Deleter deleter) noexcept;
 		~Blob() noexcept;
 		Blob(const Blob&) = delete;
 		Blob& operator=(const Blob&) = delete;
@@ -36,8 +45,11 @@ namespace FoxEngine
 		std::byte* data() { return mData; }
 		const std::byte* data() const { return mData; }
 		const std::size_t size() const { return mSize; }
+		std::span<const std::byte> span() const { return { mData, mSize }; }
+		std::string_view string() const { return { reinterpret_cast<const char*>(mData), mSize }; }
 	private:
 		std::byte* mData{};
 		std::size_t mSize{};
+		Deleter mDeleter{};
 	};
-}
\ No newline at end of file
+}
@@ -1,8 +1,16 @@
 #include "mesh.hpp"
 
+#include "Buffer.hpp"
+#include "shader.hpp"
+#include "ogl/StateCacheOGL.hpp"
+
 #include <glad/gl.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef> // offsetof
+#include <memory>
+#include <vector>
 
 namespace FoxEngine
 {
@@ -12,9 +20,11 @@ namespace FoxEngine
 		MeshOGL33(const Mesh::CreateInfo& info)
 		{
 			mCount = info.indices.size();
+			mVertexCount = info.vertices.size();
+			mBounds = Bounds::FromVertices(info.vertices);
 
 			glGenVertexArrays(1, &mVao);
-			glBindVertexArray(mVao);
+			StateCacheOGL::Get().BindVertexArray(mVao);
 
 			// Apply to buffer objects too with changes to the name
 			if (GLAD_GL_KHR_debug && !info.debugName.empty())
@@ -37,7 +47,7 @@ namespace FoxEngine
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEbo);
 			glBufferData(GL_ELEMENT_ARRAY_BUFFER, info.indices.size_bytes(), info.indices.data(), GL_STATIC_DRAW);
 
-			glBindVertexArray(0);
+			StateCacheOGL::Get().BindVertexArray(0);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
@@ -45,7 +55,10 @@ namespace FoxEngine
 		virtual ~MeshOGL33() noexcept
 		{
 			if (mVao)
+			{
+				StateCacheOGL::Get().ForgetVertexArray(mVao);
 				glDeleteVertexArrays(1, &mVao);
+			}
 
 			if (mVbo)
 				glDeleteBuffers(1, &mVbo);
@@ -56,16 +69,126 @@ namespace FoxEngine
 
 		void Draw() override
 		{
-			glBindVertexArray(mVao);
+			Bind();
+			DrawBound();
+		}
+
+		void Bind() override
+		{
+			StateCacheOGL::Get().BindVertexArray(mVao);
+		}
+
+		void DrawBound() override
+		{
 			glDrawElements(GL_TRIANGLES, mCount, GL_UNSIGNED_INT, nullptr);
 		}
+
+		void BindInstances(const Buffer& buffer, std::size_t offset) override
+		{
+			using Instance = Shader::InstanceData;
+
+			glBindBuffer(GL_ARRAY_BUFFER, buffer.Handle());
+
+			// Enabled on first use only, meshes that are never instanced keep drawing without an instance buffer
+			if (!mInstanced)
+			{
+				for (unsigned int i = 0; i < 4; ++i)
+				{
+					glEnableVertexAttribArray(Shader::InstanceModelLocation + i);
+					glVertexAttribDivisor(Shader::InstanceModelLocation + i, 1);
+				}
+
+				for (unsigned int i = 0; i < 3; ++i)
+				{
+					glEnableVertexAttribArray(Shader::InstanceNormalMatrixLocation + i);
+					glVertexAttribDivisor(Shader::InstanceNormalMatrixLocation + i, 1);
+				}
+
+				mInstanced = true;
+			}
+
+			for (unsigned int i = 0; i < 4; ++i)
+				glVertexAttribPointer(Shader::InstanceModelLocation + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, model) + sizeof(glm::vec4) * i));
+
+			for (unsigned int i = 0; i < 3; ++i)
+				glVertexAttribPointer(Shader::InstanceNormalMatrixLocation + i, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, normalMatrix) + sizeof(glm::vec4) * i));
+		}
+
+		void DrawBoundInstanced(unsigned int count) override
+		{
+			glDrawElementsInstanced(GL_TRIANGLES, mCount, GL_UNSIGNED_INT, nullptr, count);
+		}
+
+		const Geometry& GetGeometry() override
+		{
+			if (!mGeometry)
+			{
+				std::vector<Vertex> vertices(mVertexCount);
+				std::vector<Index> indices(mCount);
+
+				// The copy target leaves the vertex array's element buffer binding alone
+				glBindBuffer(GL_COPY_READ_BUFFER, mVbo);
+				glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+				glBindBuffer(GL_COPY_READ_BUFFER, mEbo);
+				glGetBufferSubData(GL_COPY_READ_BUFFER, 0, indices.size() * sizeof(Index), indices.data());
+				glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+				mGeometry = std::make_unique<Geometry>(Geometry::FromData(vertices, indices));
+			}
+
+			return *mGeometry;
+		}
 	private:
 		unsigned int mVao;
 		unsigned int mVbo;
 		unsigned int mEbo;
 		int mCount;
+		std::size_t mVertexCount;
+		bool mInstanced = false;
+		std::unique_ptr<Geometry> mGeometry;
 	};
 
+	Mesh::Bounds Mesh::Bounds::FromVertices(std::span<const Vertex> vertices)
+	{
+		Bounds bounds;
+		if (vertices.empty()) return bounds;
+
+		bounds.min = bounds.max = vertices[0].position;
+
+		for (const Vertex& vertex : vertices)
+		{
+			bounds.min = glm::min(bounds.min, vertex.position);
+			bounds.max = glm::max(bounds.max, vertex.position);
+		}
+
+		// Centered on the box, not minimal but never larger than the box's own sphere
+		bounds.center = (bounds.min + bounds.max) * 0.5f;
+
+		float radiusSquared = 0.0f;
+		for (const Vertex& vertex : vertices)
+		{
+			glm::vec3 offset = vertex.position - bounds.center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+
+		bounds.radius = std::sqrt(radiusSquared);
+
+		return bounds;
+	}
+
+	Mesh::Geometry Mesh::Geometry::FromData(std::span<const Vertex> vertices, std::span<const Index> indices)
+	{
+		Geometry geometry;
+		geometry.positions.reserve(vertices.size());
+
+		for (const Vertex& vertex : vertices)
+			geometry.positions.push_back(vertex.position);
+
+		geometry.indices.assign(indices.begin(), indices.end());
+
+		return geometry;
+	}
+
 	std::unique_ptr<Mesh> Mesh::Create(const Mesh::CreateInfo& info)
 	{
 		return std::make_unique<MeshOGL33>(info);
@@ -5,12 +5,15 @@
 #include <span>
 #include <memory>
 #include <string_view>
+#include <vector>
 
 // Meshes aren't final either, May not nessesarily always want to use this vertex format,
 // perhaps allow it to be changed in a render pipeline down the line??
 
 namespace FoxEngine
 {
+	class Buffer;
+
 	class Mesh
 	{
 	public:
@@ -23,10 +26,30 @@ namespace FoxEngine
 
 		using Index = unsigned int;
 
+		// Local space bounds, computed once from the vertices at creation
+		struct Bounds final
+		{
+			glm::vec3 min{};
+			glm::vec3 max{};
+			glm::vec3 center{}; // Shared by the box and the sphere
+			float radius = 0.0f;
+
+			static Bounds FromVertices(std::span<const Vertex> vertices);
+		};
+
+		// Positions and indices kept on the cpu for the software occlusion rasterizer
+		struct Geometry final
+		{
+			std::vector<glm::vec3> positions;
+			std::vector<Index> indices;
+
+			static Geometry FromData(std::span<const Vertex> vertices, std::span<const Index> indices);
+		};
+
 		struct CreateInfo final
 		{
-			std::span<Vertex> vertices;
-			std::span<Index> indices;
+			std::span<const Vertex> vertices;
+			std::span<const Index> indices;
 			std::string_view debugName;
 		};
 
@@ -40,6 +63,23 @@ namespace FoxEngine
 		Mesh(Mesh&&) noexcept = delete;
 		Mesh& operator=(Mesh&&) noexcept = delete;
 
+		const Bounds& GetBounds() const noexcept { return mBounds; }
+
+		// Read back from the gpu buffers on first request and kept afterwards, so only meshes used as occluders
+		// hold a cpu copy. The first call stalls until the upload is done
+		virtual const Geometry& GetGeometry() = 0;
+
 		virtual void Draw() = 0;
+
+		// Split version of Draw, lets a caller skip the bind when consecutive draws use the same mesh
+		virtual void Bind() = 0;
+		virtual void DrawBound() = 0;
+
+		// Points the instance inputs at Shader::InstanceData records starting at offset, the mesh must be bound.
+		// Gl 3.3 has no base instance, so every instanced group rebinds at its own offset
+		virtual void BindInstances(const Buffer& buffer, std::size_t offset) = 0;
+		virtual void DrawBoundInstanced(unsigned int count) = 0;
+	protected:
+		Bounds mBounds;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "ProgramCacheOGL.hpp"
+
+#include "../blob.hpp"
+#include "../log.hpp"
+
+#include <glad/gl.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace FoxEngine::ProgramCacheOGL
+{
+	static constexpr std::uint32_t Magic = 0x42504546; // "FEPB"
+	static constexpr std::uint32_t Version = 1;
+	static constexpr const char* Directory = "shader_cache";
+
+	struct Header final
+	{
+		std::uint32_t magic = Magic;
+		std::uint32_t version = Version;
+		std::uint64_t key = 0;
+		std::uint32_t format = 0;
+		std::uint32_t length = 0;
+		double compileMilliseconds = 0.0;
+	};
+
+	static Stats sStats;
+
+	static std::uint64_t Fnv1a(std::uint64_t hash, std::string_view data)
+	{
+		for (char c : data)
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 0x100000001B3ull;
+		}
+
+		// Separator so ("ab", "c") and ("a", "bc") hash differently
+		hash ^= 0xFF;
+		hash *= 0x100000001B3ull;
+
+		return hash;
+	}
+
+	static std::string_view GetString(unsigned int name)
+	{
+		const char* string = reinterpret_cast<const char*>(glGetString(name));
+		return string ? string : "";
+	}
+
+	static std::string PathFor(std::uint64_t key)
+	{
+		return Log::FormatArgs("{}/{:016x}.bin", Directory, key);
+	}
+
+	static void LogStats()
+	{
+		Log::Info("Program cache: {} hits, {} misses, {} rejected, {:.2f} ms saved", sStats.hits, sStats.misses, sStats.rejected, sStats.savedMilliseconds);
+	}
+
+	bool IsSupported()
+	{
+		static const bool supported = []
+			{
+				if (!GLAD_GL_ARB_get_program_binary) return false;
+
+				int formats = 0;
+				glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+				return formats > 0;
+			}();
+
+		return supported;
+	}
+
+	std::uint64_t Key(std::span<const std::string_view> vertSources, std::span<const std::string_view> fragSources)
+	{
+		std::uint64_t hash = 0xCBF29CE484222325ull;
+		hash = Fnv1a(hash, GetString(GL_VENDOR));
+		hash = Fnv1a(hash, GetString(GL_RENDERER));
+		hash = Fnv1a(hash, GetString(GL_VERSION));
+
+		for (std::string_view source : vertSources)
+			hash = Fnv1a(hash, source);
+
+		for (std::string_view source : fragSources)
+			hash = Fnv1a(hash, source);
+
+		return hash;
+	}
+
+	bool Load(unsigned int program, std::uint64_t key)
+	{
+		std::string path = PathFor(key);
+
+		if (!std::filesystem::exists(path))
+		{
+			++sStats.misses;
+			LogStats();
+			return false;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		Blob blob;
+
+		try
+		{
+			blob = Blob::MapFile(path);
+		}
+		catch (const Exception::FileRead&)
+		{
+			++sStats.misses;
+			LogStats();
+			return false;
+		}
+
+		const Header* header = reinterpret_cast<const Header*>(blob.data());
+
+		bool valid = blob.size() >= sizeof(Header)
+			&& header->magic == Magic
+			&& header->version == Version
+			&& header->key == key
+			&& blob.size() == sizeof(Header) + header->length;
+
+		if (valid)
+		{
+			glProgramBinary(program, header->format, blob.data() + sizeof(Header), header->length);
+
+			int status = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &status);
+			valid = status == GL_TRUE;
+		}
+
+		if (!valid)
+		{
+			// Usually a driver update, the entry is overwritten once the program is compiled again
+			++sStats.rejected;
+			++sStats.misses;
+			Log::Warn("Program binary rejected: {}", path);
+			LogStats();
+			return false;
+		}
+
+		double loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		double saved = header->compileMilliseconds - loadMilliseconds;
+
+		++sStats.hits;
+		sStats.savedMilliseconds += saved;
+
+		Log::Info("Program cache hit: {} ({:.2f} ms, saved {:.2f} ms)", path, loadMilliseconds, saved);
+		LogStats();
+
+		return true;
+	}
+
+	void Store(unsigned int program, std::uint64_t key, double compileMilliseconds)
+	{
+		int length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		if (length <= 0) return;
+
+		std::vector<char> binary(length);
+
+		Header header;
+		header.key = key;
+		header.compileMilliseconds = compileMilliseconds;
+
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+
+		header.format = format;
+		header.length = static_cast<std::uint32_t>(length);
+
+		std::error_code ec;
+		std::filesystem::create_directories(Directory, ec);
+
+		std::string path = PathFor(key);
+		std::string tempPath = path + ".tmp";
+
+		{
+			std::ofstream out{ tempPath, std::ios::out | std::ios::binary | std::ios::trunc };
+
+			if (!out)
+			{
+				Log::Warn("Failed to write program binary: {}", path);
+				return;
+			}
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(binary.data(), length);
+
+			if (!out)
+			{
+				out.close();
+				std::filesystem::remove(tempPath, ec);
+				Log::Warn("Failed to write program binary: {}", path);
+				return;
+			}
+		}
+
+		// Replaced in one step so a concurrent or interrupted run never sees a partial entry
+		std::filesystem::rename(tempPath, path, ec);
+
+		if (ec)
+		{
+			std::filesystem::remove(tempPath, ec);
+			Log::Warn("Failed to replace program binary: {}", path);
+		}
+	}
+
+	const Stats& GetStats()
+	{
+		return sStats;
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// On disk cache of linked program binaries (ARB_get_program_binary)
+// Binaries are only valid for the exact driver that produced them, so the driver strings are part of the key
+
+namespace FoxEngine::ProgramCacheOGL
+{
+	struct Stats final
+	{
+		unsigned int hits = 0;
+		unsigned int misses = 0;
+		unsigned int rejected = 0; // Found on disk but refused by the driver
+		double savedMilliseconds = 0.0;
+	};
+
+	bool IsSupported();
+
+	// Hash of the fully preprocessed sources and the driver vendor, renderer and version strings.
+	// Each stage is given as the strings handed to glShaderSource, each string is hashed followed by a separator so boundaries matter
+	std::uint64_t Key(std::span<const std::string_view> vertSources, std::span<const std::string_view> fragSources);
+
+	// Returns true if the program was loaded and linked successfully, on false the program must be compiled from source
+	bool Load(unsigned int program, std::uint64_t key);
+
+	// The program must be linked, compileMilliseconds is reported as time saved on later hits
+	void Store(unsigned int program, std::uint64_t key, double compileMilliseconds);
+
+	const Stats& GetStats();
+}
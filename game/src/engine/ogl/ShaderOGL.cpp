@@ -1,115 +1,306 @@
 #include "ShaderOGL.hpp"
 
 #include "../Blob.hpp"
+#include "../CpuProfiler.hpp"
 #include "../Log.hpp"
-#include "../experimental/Badge.hpp"
+#include "../ShaderPreprocessor.hpp"
+#include "ProgramCacheOGL.hpp"
+#include "StateCacheOGL.hpp"
 
 #include <glad/gl.h>
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <span>
 #include <utility>
-#include <regex>
 
 namespace FoxEngine
 {
-	struct ShaderDeleter final
+	// Only issues the compile, errors are collected by CheckShader so the driver is free to finish it in the background.
+	// The strings are concatenated by the driver, so the shared preamble and the source are never joined here
+	static unsigned int CompileShader(unsigned int type, std::span<const std::string_view, 2> strings)
 	{
-		void operator()(unsigned int value) const
+		const char* cStrs[strings.extent];
+		int sizes[strings.extent];
+
+		for (std::size_t i = 0; i < strings.size(); ++i)
 		{
-			glDeleteShader(value);
+			cStrs[i] = strings[i].data();
+			sizes[i] = static_cast<int>(strings[i].size());
 		}
-	};
-
-	static Experimental::Deleter<unsigned int, ShaderDeleter> CreateShader(unsigned int type, std::string_view string)
-	{
-		const char* cStr = string.data();
-		int size = string.size();
 
-		Experimental::Deleter<unsigned int, ShaderDeleter> shader = glCreateShader(type);
-		glShaderSource(shader, 1, &cStr, &size);
+		unsigned int shader = glCreateShader(type);
+		glShaderSource(shader, static_cast<int>(strings.size()), cStrs, sizes);
 		glCompileShader(shader);
 
-		int logLength;
+		return shader;
+	}
+
+	// Throws if compiling failed, a log on success only holds warnings
+	static void CheckShader(unsigned int shader, std::string_view name, std::string_view sourceTable)
+	{
+		int status = GL_FALSE;
+		int logLength = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
 		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
 
-		if (logLength > 0)
+		if (logLength > 1)
 		{
 			std::string string;
 			string.resize(logLength);
 
 			glGetShaderInfoLog(shader, logLength, nullptr, string.data());
 
-			throw std::runtime_error{ string };
+			if (!status)
+				throw std::runtime_error{ string + "\n" + std::string(sourceTable) };
+
+			Log::Warn("Shader compiled with warnings {}: {}\n{}", name, string, sourceTable);
 		}
+		else if (!status)
+		{
+			throw std::runtime_error{ "Shader failed to compile without a log\n" + std::string(sourceTable) };
+		}
+	}
 
-		return shader;
+	static void EnableParallelCompile()
+	{
+		static const bool enabled = []
+			{
+				if (!GLAD_GL_KHR_parallel_shader_compile) return false;
+
+				// Let the driver pick the thread count
+				glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+				return true;
+			}();
+
+		(void)enabled;
 	}
 
-	ShaderOGL33::ShaderOGL33(const Shader::CreateInfo& info)
+	// Bound to Shader::CameraBinding after linking, see Shader::CameraBlock
+	static constexpr const char* BuiltinBlocks =
+		"layout(std140) uniform FeCamera\n"
+		"{\n"
+		"	mat4 feView;\n"
+		"	mat4 feProjection;\n"
+		"	mat4 feViewProjection;\n"
+		"	vec4 feCameraPosition;\n"
+		"};\n\n";
+
+	// Per instance inputs, see Shader::InstanceData. Only the vertex stage can read them
+	static constexpr const char* BuiltinInstanceInputs =
+		"layout(location = 3) in mat4 feModel;\n"
+		"layout(location = 7) in mat3 feNormalMatrix;\n\n";
+
+	static_assert(Shader::InstanceModelLocation == 3 && Shader::InstanceNormalMatrixLocation == 7, "Update BuiltinInstanceInputs");
+
+	// Replaces programs that failed to build once they are used, flat magenta so the mistake is easy to spot
+	static constexpr std::string_view ErrorShaderSource = R"(
+input(vec3, inPosition, 0);
+
+output(vec4, outColor, 0);
+output(vec4, outBlack, 1);
+
+#ifdef FE_VERT
+void main(void)
+{
+	gl_Position = feViewProjection * feModel * vec4(inPosition, 1.0);
+}
+#elif defined FE_FRAG
+void main(void)
+{
+	outColor = vec4(1.0, 0.0, 1.0, 1.0);
+	outBlack = vec4(0.0, 0.0, 0.0, 1.0);
+}
+#endif
+)";
+
+	// Keywords end up verbatim in a #define, so they have to be plain identifiers
+	static bool IsValidKeyword(std::string_view keyword)
 	{
-		std::string common_pre = "#version 330 core\n\n";
-		std::string common_post = "#line 1\n";
+		if (keyword.empty() || (keyword[0] >= '0' && keyword[0] <= '9')) return false;
 
-		std::string vertCommon = common_pre + "#define FE_VERT\n#define varying(type, name) out type name\n#define input(type, name, index) layout(location = index) in type name\n#define output(type, name, index)\n\n" + common_post;
-		std::string fragCommon = common_pre + "#define FE_FRAG\n#define varying(type, name) in type name\n#define input(type, name, index)\n#define output(type, name, index) layout(location = index) out type name\n\n" + common_post;
+		for (char c : keyword)
+			if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'))
+				return false;
 
-		Blob source = Blob::FromFile(info.filename);
-		std::string stringSource = std::string(reinterpret_cast<char*>(source.data()), source.size());
+		return true;
+	}
 
-		// Pragmas
-		{
-			std::regex regex("^@pragma\\s+([A-Za-z_]+)\\s");
+	ShaderOGL33::ShaderOGL33(const Shader::CreateInfo& info)
+	{
+		FE_PROFILE_SCOPE("Shader compile");
 
-			std::smatch match;
+		std::string common_pre = "#version 330 core\n\n";
 
-			while (std::regex_search(stringSource, match, regex))
+		for (const std::string& keyword : info.keywords)
+		{
+			if (!IsValidKeyword(keyword))
 			{
-				std::string matches = match[1].str();
+				Log::Warn("Ignoring invalid shader keyword: {}", keyword);
+				continue;
+			}
 
-				Log::Info("Foxengine shader pragma: {}", matches);
+			common_pre += "#define " + keyword + "\n";
+		}
 
-				if (matches == "backface_nocull")
-					mCullsBackfaces = false;
-				else Log::Warn("Unknown shader pragma");
+		if (!info.keywords.empty())
+			common_pre += "\n";
 
-				stringSource = match.prefix().str() + "// (FoxEngine Preprocess) -> " + match[0].str() + match.suffix().str();
-			}
+		common_pre += BuiltinBlocks;
+		std::string common_post = "#line 1 0\n"; // The main file is string 0 of the source table, not its array index
+
+		std::string vertCommon = common_pre + BuiltinInstanceInputs + "#define FE_VERT\n#define varying(type, name) out type name\n#define input(type, name, index) layout(location = index) in type name\n#define output(type, name, index)\n\n" + common_post;
+		std::string fragCommon = common_pre + "#define FE_FRAG\n#define varying(type, name) in type name\n#define input(type, name, index)\n#define output(type, name, index) layout(location = index) out type name\n\n" + common_post;
+
+		Blob file;
+		std::string_view source = info.source;
+
+		if (source.empty())
+		{
+			file = Blob::MapFile(info.filename);
+			source = file.string();
 		}
 
+		ShaderPreprocessor::Result preprocessed = ShaderPreprocessor::Process(info.filename, source);
+		mCullsBackfaces = preprocessed.cullsBackFaces;
+
+		// Appended to compile errors, drivers only report the source string number
+		std::string sourceTable = "Source strings:";
+		for (std::size_t i = 0; i < preprocessed.files.size(); ++i)
+			sourceTable += Log::FormatArgs(" {} = {}", i, preprocessed.files[i]);
+
 		// must be matched differently for each shader type
 		// Input
 		// {
 		// 	std::regex regex("^@in\\s+([A-Za-z0-9_]+)\\s+([A-Za-z0-9_]+)\\s*=\\s*([0-9]+)\\s*;");
 		// }
 
-		std::string vertSource = vertCommon + stringSource;
-		std::string fragSource = fragCommon + stringSource;
-
-		auto vert = CreateShader(GL_VERTEX_SHADER, vertSource);
-		auto frag = CreateShader(GL_FRAGMENT_SHADER, fragSource);
+		const std::string_view vertSources[] = { vertCommon, preprocessed.source };
+		const std::string_view fragSources[] = { fragCommon, preprocessed.source };
 
+		mName = info.filename;
 		mHandle = glCreateProgram();
 
 		if (GLAD_GL_KHR_debug && !info.debugName.empty())
 			glObjectLabel(GL_PROGRAM, mHandle, info.debugName.size(), info.debugName.data());
 
-		glAttachShader(mHandle, vert);
-		glAttachShader(mHandle, frag);
+		const bool cacheSupported = ProgramCacheOGL::IsSupported();
+
+		if (cacheSupported)
+		{
+			mCacheKey = ProgramCacheOGL::Key(vertSources, fragSources);
+
+			if (ProgramCacheOGL::Load(mHandle, mCacheKey))
+			{
+				ReflectUniforms();
+				return;
+			}
+		}
+
+		EnableParallelCompile();
+
+		mCompileStart = std::chrono::steady_clock::now();
+		mSourceTable = std::move(sourceTable);
+		mStoreInCache = cacheSupported;
+
+		mVert = CompileShader(GL_VERTEX_SHADER, vertSources);
+		mFrag = CompileShader(GL_FRAGMENT_SHADER, fragSources);
+
+		glAttachShader(mHandle, mVert);
+		glAttachShader(mHandle, mFrag);
+
+		if (cacheSupported)
+			glProgramParameteri(mHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
 		glLinkProgram(mHandle);
 
-		int logLength;
+		mPending = true;
+
+		if (!info.async)
+			Finish();
+	}
+
+	bool ShaderOGL33::IsReady()
+	{
+		if (!mPending) return true;
+
+		// Without the extension there is no way to ask without blocking, so the first poll finishes the program
+		if (GLAD_GL_KHR_parallel_shader_compile)
+		{
+			int completed = GL_FALSE;
+			glGetProgramiv(mHandle, GL_COMPLETION_STATUS_KHR, &completed);
+			if (!completed) return false;
+		}
+
+		Finish();
+		return true;
+	}
+
+	void ShaderOGL33::Finish()
+	{
+		FE_PROFILE_SCOPE("Shader link");
+
+		mPending = false;
+
+		// Release the shader objects no matter how this ends
+		struct Cleanup final
+		{
+			ShaderOGL33& self;
+
+			~Cleanup()
+			{
+				glDetachShader(self.mHandle, self.mVert);
+				glDetachShader(self.mHandle, self.mFrag);
+				glDeleteShader(self.mVert);
+				glDeleteShader(self.mFrag);
+				self.mVert = 0;
+				self.mFrag = 0;
+				self.mSourceTable = {};
+			}
+		} cleanup{ *this };
+
+		CheckShader(mVert, mName, mSourceTable);
+		CheckShader(mFrag, mName, mSourceTable);
+
+		int status = GL_FALSE;
+		int logLength = 0;
+		glGetProgramiv(mHandle, GL_LINK_STATUS, &status);
 		glGetProgramiv(mHandle, GL_INFO_LOG_LENGTH, &logLength);
 
-		if (logLength > 0)
+		if (logLength > 1)
 		{
 			std::string string;
 			string.resize(logLength);
 
 			glGetProgramInfoLog(mHandle, logLength, nullptr, string.data());
 
-			throw std::runtime_error{ string };
+			if (!status)
+				throw std::runtime_error{ string };
+
+			Log::Warn("Shader linked with warnings {}: {}", mName, string);
+		}
+		else if (!status)
+		{
+			throw std::runtime_error{ "Shader failed to link without a log" };
+		}
+
+		if (mStoreInCache)
+		{
+			// For async shaders this includes the frames spent waiting, so it is an upper bound
+			double compileMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mCompileStart).count();
+			ProgramCacheOGL::Store(mHandle, mCacheKey, compileMilliseconds);
 		}
 
+		ReflectUniforms();
+	}
+
+	void ShaderOGL33::ReflectUniforms()
+	{
+		// Glsl 330 has no layout(binding), so the fixed binding points are assigned here. Inactive blocks return GL_INVALID_INDEX
+		if (unsigned int camera = glGetUniformBlockIndex(mHandle, "FeCamera"); camera != GL_INVALID_INDEX)
+			glUniformBlockBinding(mHandle, camera, Shader::CameraBinding);
+
 		GLint uniform_count = 0;
 		glGetProgramiv(mHandle, GL_ACTIVE_UNIFORMS, &uniform_count);
 
@@ -123,7 +314,7 @@ namespace FoxEngine
 
 			auto uniform_name = std::make_unique<char[]>(max_name_len);
 
-			Log::Info("Uniform lookups: {}", info.filename);
+			Log::Info("Uniform lookups: {}", mName);
 
 			for (GLint i = 0; i < uniform_count; ++i)
 			{
@@ -140,8 +331,14 @@ namespace FoxEngine
 
 	ShaderOGL33::~ShaderOGL33() noexcept
 	{
+		if (mVert) glDeleteShader(mVert);
+		if (mFrag) glDeleteShader(mFrag);
+
 		if (mHandle)
+		{
+			StateCacheOGL::Get().ForgetProgram(mHandle);
 			glDeleteProgram(mHandle);
+		}
 	}
 
 	ShaderOGL33::ShaderOGL33(ShaderOGL33&& other) noexcept
@@ -154,13 +351,83 @@ namespace FoxEngine
 		std::swap(mHandle, other.mHandle);
 		std::swap(mUniforms, other.mUniforms);
 		std::swap(mCullsBackfaces, other.mCullsBackfaces);
+		std::swap(mPending, other.mPending);
+		std::swap(mStoreInCache, other.mStoreInCache);
+		std::swap(mVert, other.mVert);
+		std::swap(mFrag, other.mFrag);
+		std::swap(mCacheKey, other.mCacheKey);
+		std::swap(mCompileStart, other.mCompileStart);
+		std::swap(mSourceTable, other.mSourceTable);
+		std::swap(mName, other.mName);
 
 		return *this;
 	}
 
+	void ShaderOGL33::FinishOrFallback()
+	{
+		try
+		{
+			Finish();
+		}
+		catch (const std::exception& e)
+		{
+			Log::Error("Failed to create shader {}, drawing it with the error shader: {}", mName, e.what());
+
+			std::string name = mName;
+			*this = ShaderOGL33(
+				{
+					.filename = "(error)",
+					.source = ErrorShaderSource,
+					.debugName = "Error shader"
+				});
+			mName = std::move(name);
+		}
+	}
+
 	void ShaderOGL33::Bind()
 	{
-		glUseProgram(mHandle);
+		// Only reached when a pending shader is used before ResourceManager polled it, this may be mid frame so nothing is thrown
+		if (mPending) FinishOrFallback();
+
+		StateCacheOGL::Get().UseProgram(mHandle);
+	}
+
+	int ShaderOGL33::FindUniform(std::string_view name)
+	{
+		// Uniforms are only known once the program is linked
+		if (mPending) FinishOrFallback();
+
+		auto it = mUniforms.find(name);
+		return it == mUniforms.end() ? -1 : it->second;
+	}
+
+	// Location -1 is silently ignored by gl, so unresolved handles need no check
+	// The state cache skips values the program already holds
+	void ShaderOGL33::Set(Uniform<int> uniform, int v0)
+	{
+		// Cached as a float, exact for any sampler unit
+		float value = static_cast<float>(v0);
+
+		if (StateCacheOGL::Get().UpdateUniform(mHandle, uniform.location, { &value, 1 }))
+			glUniform1i(uniform.location, v0);
+	}
+
+	void ShaderOGL33::Set(Uniform<float> uniform, float v0)
+	{
+		if (StateCacheOGL::Get().UpdateUniform(mHandle, uniform.location, { &v0, 1 }))
+			glUniform1f(uniform.location, v0);
+	}
+
+	void ShaderOGL33::Set(Uniform<glm::vec2> uniform, const glm::vec2& v0)
+	{
+		if (StateCacheOGL::Get().UpdateUniform(mHandle, uniform.location, { &v0.x, 2 }))
+			glUniform2f(uniform.location, v0.x, v0.y);
+	}
+
+	void ShaderOGL33::Set(Uniform<glm::mat4> uniform, const glm::mat4& v0)
+	{
+		if (StateCacheOGL::Get().UpdateUniform(mHandle, uniform.location, { &v0[0][0], 16 }))
+			glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &v0[0][0]);
 	}
 
 	void ShaderOGL33::Uniform1f(std::string_view name, float v0)
@@ -169,7 +436,7 @@ namespace FoxEngine
 		if (it == mUniforms.end()) return;
 
 		Bind();
-		glUniform1f(it->second, v0);
+		Set(Uniform<float>{ it->second }, v0);
 	}
 
 	void ShaderOGL33::Uniform2f(std::string_view name, float v0, float v1)
@@ -178,7 +445,7 @@ namespace FoxEngine
 		if (it == mUniforms.end()) return;
 
 		Bind();
-		glUniform2f(it->second, v0, v1);
+		Set(Uniform<glm::vec2>{ it->second }, glm::vec2(v0, v1));
 	}
 
 	void ShaderOGL33::UniformMat4f(std::string_view name, const float* v0)
@@ -187,6 +454,9 @@ namespace FoxEngine
 		if (it == mUniforms.end()) return;
 
 		Bind();
-		glUniformMatrix4fv(it->second, 1, GL_FALSE, v0);
+
+		glm::mat4 value;
+		std::memcpy(&value[0][0], v0, sizeof(value));
+		Set(Uniform<glm::mat4>{ it->second }, value);
 	}
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "../Shader.hpp"
 #include "../UnorderedMapString.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 
@@ -22,13 +24,37 @@ namespace FoxEngine
 
 		void Bind() override;
 
+		void Set(Uniform<int> uniform, int v0) override;
+		void Set(Uniform<float> uniform, float v0) override;
+		void Set(Uniform<glm::vec2> uniform, const glm::vec2& v0) override;
+		void Set(Uniform<glm::mat4> uniform, const glm::mat4& v0) override;
+
 		void Uniform1f(std::string_view name, float v0) override;
 		void Uniform2f(std::string_view name, float v0, float v1) override;
 		void UniformMat4f(std::string_view name, const float* v0) override;
 		bool CullsBackFaces() const noexcept override { return mCullsBackfaces; }
+		bool IsReady() override;
+	protected:
+		int FindUniform(std::string_view name) override;
+	private:
+		// Collects compile and link results, throws on errors
+		void Finish();
+
+		// Finish for use while drawing, a failed program is replaced by the error shader instead of throwing
+		void FinishOrFallback();
+
+		void ReflectUniforms();
 	private:
 		bool mCullsBackfaces = true;
+		bool mPending = false; // Compile and link were issued but not checked yet
+		bool mStoreInCache = false;
 		unsigned int mHandle = 0;
+		unsigned int mVert = 0;
+		unsigned int mFrag = 0;
+		std::uint64_t mCacheKey = 0;
+		std::chrono::steady_clock::time_point mCompileStart;
+		std::string mSourceTable;
+		std::string mName;
 		UnorderedStringMap<int> mUniforms;
 	};
 }
\ No newline at end of file
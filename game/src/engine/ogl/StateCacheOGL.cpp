@@ -0,0 +1,212 @@
+#include "StateCacheOGL.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace FoxEngine
+{
+	StateCacheOGL& StateCacheOGL::Get()
+	{
+		thread_local StateCacheOGL cache;
+		return cache;
+	}
+
+	StateCacheOGL::StateCacheOGL()
+	{
+		Invalidate();
+	}
+
+	int StateCacheOGL::TargetIndex(unsigned int target)
+	{
+		switch (target)
+		{
+		case GL_TEXTURE_1D:
+			return 0;
+		case GL_TEXTURE_2D:
+			return 1;
+		case GL_TEXTURE_3D:
+			return 2;
+		case GL_TEXTURE_CUBE_MAP:
+			return 3;
+		}
+
+		return -1;
+	}
+
+	bool StateCacheOGL::Change(unsigned int& current, unsigned int value)
+	{
+		if (current == value)
+		{
+			++mStats.skipped;
+			return false;
+		}
+
+		current = value;
+		++mStats.issued;
+		return true;
+	}
+
+	void StateCacheOGL::UseProgram(unsigned int program)
+	{
+		if (Change(mProgram, program))
+			glUseProgram(program);
+	}
+
+	void StateCacheOGL::BindVertexArray(unsigned int vao)
+	{
+		if (Change(mVertexArray, vao))
+			glBindVertexArray(vao);
+	}
+
+	void StateCacheOGL::ActiveTexture(unsigned int unit)
+	{
+		if (Change(mActiveUnit, unit))
+			glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	void StateCacheOGL::BindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+	{
+		int index = TargetIndex(target);
+
+		if (unit >= MaxTextureUnits || index < 0)
+		{
+			// Not tracked, whatever was cached for the unit may be stale now
+			ActiveTexture(unit);
+			glBindTexture(target, texture);
+			++mStats.issued;
+
+			if (unit < MaxTextureUnits)
+				std::fill(std::begin(mTextures[unit]), std::end(mTextures[unit]), Unknown);
+
+			return;
+		}
+
+		if (mTextures[unit][index] == texture)
+		{
+			++mStats.skipped;
+			return;
+		}
+
+		ActiveTexture(unit);
+		Change(mTextures[unit][index], texture);
+		glBindTexture(target, texture);
+	}
+
+	void StateCacheOGL::BindFramebuffer(unsigned int framebuffer)
+	{
+		if (Change(mFramebuffer, framebuffer))
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	}
+
+	void StateCacheOGL::SetEnabled(unsigned int cap, bool enabled)
+	{
+		auto it = std::find_if(mCapabilities.begin(), mCapabilities.end(), [cap](const Capability& capability) { return capability.cap == cap; });
+
+		if (it == mCapabilities.end())
+			it = mCapabilities.insert(mCapabilities.end(), { cap, Unknown });
+
+		if (!Change(it->state, enabled))
+			return;
+
+		if (enabled)
+			glEnable(cap);
+		else
+			glDisable(cap);
+	}
+
+	void StateCacheOGL::BlendFunc(unsigned int source, unsigned int destination)
+	{
+		if (mBlendSource == source && mBlendDestination == destination)
+		{
+			++mStats.skipped;
+			return;
+		}
+
+		mBlendSource = source;
+		mBlendDestination = destination;
+		++mStats.issued;
+		glBlendFunc(source, destination);
+	}
+
+	void StateCacheOGL::DepthFunc(unsigned int func)
+	{
+		if (Change(mDepthFunc, func))
+			glDepthFunc(func);
+	}
+
+	void StateCacheOGL::DepthMask(bool enabled)
+	{
+		if (Change(mDepthMask, enabled))
+			glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	}
+
+	bool StateCacheOGL::UpdateUniform(unsigned int program, int location, std::span<const float> values)
+	{
+		// Gl ignores location -1, so there is nothing to issue
+		if (location < 0 || values.size() > 16)
+			return location >= 0;
+
+		std::uint64_t key = static_cast<std::uint64_t>(program) << 32 | static_cast<std::uint32_t>(location);
+		auto [it, inserted] = mUniforms.try_emplace(key);
+		UniformValue& value = it->second;
+
+		if (!inserted && value.count == values.size() && std::memcmp(value.values, values.data(), values.size_bytes()) == 0)
+		{
+			++mStats.skipped;
+			return false;
+		}
+
+		std::memcpy(value.values, values.data(), values.size_bytes());
+		value.count = static_cast<std::uint32_t>(values.size());
+		++mStats.issued;
+		return true;
+	}
+
+	void StateCacheOGL::ForgetProgram(unsigned int program)
+	{
+		if (mProgram == program)
+			mProgram = Unknown;
+
+		std::erase_if(mUniforms, [program](const auto& entry) { return (entry.first >> 32) == program; });
+	}
+
+	void StateCacheOGL::ForgetVertexArray(unsigned int vao)
+	{
+		if (mVertexArray == vao)
+			mVertexArray = Unknown;
+	}
+
+	void StateCacheOGL::ForgetTexture(unsigned int texture)
+	{
+		for (auto& unit : mTextures)
+			for (unsigned int& bound : unit)
+				if (bound == texture)
+					bound = Unknown;
+	}
+
+	void StateCacheOGL::ForgetFramebuffer(unsigned int framebuffer)
+	{
+		if (mFramebuffer == framebuffer)
+			mFramebuffer = Unknown;
+	}
+
+	void StateCacheOGL::Invalidate()
+	{
+		mProgram = Unknown;
+		mVertexArray = Unknown;
+		mFramebuffer = Unknown;
+		mActiveUnit = Unknown;
+		mBlendSource = Unknown;
+		mBlendDestination = Unknown;
+		mDepthFunc = Unknown;
+		mDepthMask = Unknown;
+
+		for (auto& unit : mTextures)
+			std::fill(std::begin(unit), std::end(unit), Unknown);
+
+		for (Capability& capability : mCapabilities)
+			capability.state = Unknown;
+	}
+}
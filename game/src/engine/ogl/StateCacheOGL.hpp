@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Shadows gl state so calls that would not change anything are never issued
+//
+// There is one cache per thread, which matches one context per thread. Code that changes tracked state
+// without going through the cache (imgui restores what it touches) or makes another context current
+// must call Invalidate afterwards. Deleted objects must be forgotten, gl reuses their names
+
+namespace FoxEngine
+{
+	class StateCacheOGL final
+	{
+	public:
+		struct Stats final
+		{
+			unsigned int issued = 0;
+			unsigned int skipped = 0;
+		};
+
+		static constexpr unsigned int MaxTextureUnits = 16;
+
+		static StateCacheOGL& Get();
+
+		StateCacheOGL();
+		StateCacheOGL(const StateCacheOGL&) = delete;
+		StateCacheOGL& operator=(const StateCacheOGL&) = delete;
+
+		void UseProgram(unsigned int program);
+		void BindVertexArray(unsigned int vao);
+		void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+		void BindFramebuffer(unsigned int framebuffer); // GL_FRAMEBUFFER, both draw and read
+
+		void SetEnabled(unsigned int cap, bool enabled);
+		void Enable(unsigned int cap) { SetEnabled(cap, true); }
+		void Disable(unsigned int cap) { SetEnabled(cap, false); }
+		void BlendFunc(unsigned int source, unsigned int destination);
+		void DepthFunc(unsigned int func);
+		void DepthMask(bool enabled);
+
+		// Returns false if the program already holds these values, otherwise records them and the caller sets the uniform
+		bool UpdateUniform(unsigned int program, int location, std::span<const float> values);
+
+		void ForgetProgram(unsigned int program);
+		void ForgetVertexArray(unsigned int vao);
+		void ForgetTexture(unsigned int texture);
+		void ForgetFramebuffer(unsigned int framebuffer);
+
+		// Everything is unknown afterwards, uniform values are kept since only the owning program can change them
+		void Invalidate();
+
+		const Stats& GetStats() const noexcept { return mStats; }
+		void ResetStats() noexcept { mStats = {}; }
+	private:
+		static constexpr unsigned int Unknown = ~0u;
+
+		// Index into the per unit bindings, targets outside this list are not cached
+		static int TargetIndex(unsigned int target);
+
+		// Counts the call and returns true if it has to be issued
+		bool Change(unsigned int& current, unsigned int value);
+
+		void ActiveTexture(unsigned int unit);
+	private:
+		struct Capability final
+		{
+			unsigned int cap;
+			unsigned int state; // 0, 1 or Unknown
+		};
+
+		struct UniformValue final
+		{
+			float values[16];
+			std::uint32_t count;
+		};
+
+		unsigned int mProgram = Unknown;
+		unsigned int mVertexArray = Unknown;
+		unsigned int mFramebuffer = Unknown;
+		unsigned int mActiveUnit = Unknown;
+		unsigned int mTextures[MaxTextureUnits][4];
+		unsigned int mBlendSource = Unknown;
+		unsigned int mBlendDestination = Unknown;
+		unsigned int mDepthFunc = Unknown;
+		unsigned int mDepthMask = Unknown;
+		std::vector<Capability> mCapabilities;
+
+		// Keyed by program << 32 | location
+		std::unordered_map<std::uint64_t, UniformValue> mUniforms;
+
+		Stats mStats;
+	};
+}
@@ -2,10 +2,62 @@
 
 #include "ogl/ShaderOGL.hpp"
 
+#include <algorithm>
+
 namespace FoxEngine
 {
 	Poly<Shader> Shader::Create(const Shader::CreateInfo& info)
 	{
 		return Poly<Shader>(NullOf<ShaderOGL33>, info);
 	}
-}
\ No newline at end of file
+
+	static_assert(sizeof(Shader::CameraBlock) == 208, "CameraBlock must match the std140 layout of FeCamera");
+	static_assert(sizeof(Shader::InstanceData) == 112, "InstanceData must be tightly packed, the instance attribute offsets depend on it");
+
+	Shader::CameraBlock Shader::CameraBlock::Make(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position)
+	{
+		return { view, projection, projection * view, glm::vec4(position, 1.0f) };
+	}
+
+	Shader::InstanceData Shader::InstanceData::Make(const glm::mat4& model)
+	{
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+		return { model, { glm::vec4(normalMatrix[0], 0.0f), glm::vec4(normalMatrix[1], 0.0f), glm::vec4(normalMatrix[2], 0.0f) } };
+	}
+
+	std::vector<std::string> Shader::ParseKeywords(std::string_view keywords)
+	{
+		std::vector<std::string> result;
+
+		while (!keywords.empty())
+		{
+			std::size_t begin = keywords.find_first_not_of(" \t\r\n,");
+			if (begin == std::string_view::npos) break;
+
+			keywords.remove_prefix(begin);
+
+			std::size_t end = keywords.find_first_of(" \t\r\n,");
+			result.emplace_back(keywords.substr(0, end));
+			keywords.remove_prefix(end == std::string_view::npos ? keywords.size() : end);
+		}
+
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+
+		return result;
+	}
+
+	std::string Shader::JoinKeywords(std::span<const std::string> keywords)
+	{
+		std::string result;
+
+		for (const std::string& keyword : keywords)
+		{
+			if (!result.empty()) result += ' ';
+			result += keyword;
+		}
+
+		return result;
+	}
+}
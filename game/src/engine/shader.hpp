@@ -1,8 +1,14 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 #include "Poly.hpp"
 
+#include <glm/glm.hpp>
+
 // Shaders need a ton of work still, mostly for preprocessing
 
 namespace FoxEngine
@@ -10,14 +16,64 @@ namespace FoxEngine
 	class Shader
 	{
 	public:
+		// Resolved uniform location, only valid for the shader that returned it
+		// Setting an unresolved uniform is a no-op, just like with a missing name
+		template<class T>
+		struct Uniform final
+		{
+			int location = -1;
+
+			explicit operator bool() const noexcept { return location != -1; }
+		};
+
+		// Engine provided std140 uniform block, every shader preamble declares it as FeCamera
+		static constexpr unsigned int CameraBinding = 0;
+
+		// Vertex inputs of the per instance data, user inputs must stay below these
+		static constexpr unsigned int InstanceModelLocation = 3; // mat4, takes 4 locations
+		static constexpr unsigned int InstanceNormalMatrixLocation = 7; // mat3, takes 3 locations
+
+		// Written once per frame
+		struct CameraBlock final
+		{
+			glm::mat4 view;
+			glm::mat4 projection;
+			glm::mat4 viewProjection;
+			glm::vec4 position; // w is unused
+
+			static CameraBlock Make(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position);
+		};
+
+		// Streamed per instance into a vertex buffer, the vertex stage sees it as feModel and feNormalMatrix
+		struct InstanceData final
+		{
+			glm::mat4 model;
+			glm::vec4 normalMatrix[3]; // Padded columns, w is unused
+
+			static InstanceData Make(const glm::mat4& model);
+		};
+
 		struct CreateInfo final
 		{
 			std::string_view filename;
+			std::string_view source; // Used instead of reading filename when set
 			std::string_view debugName;
+
+			// Each keyword becomes a #define in the preamble, every distinct set is its own program
+			std::span<const std::string> keywords;
+
+			// Returns right after issuing the compile, poll IsReady on later frames. Uses KHR_parallel_shader_compile when available
+			bool async = false;
 		};
 	public:
 		static Poly<Shader> Create(const CreateInfo& info);
 
+		// Splits on whitespace, sorts and removes duplicates so equal sets compare and hash the same
+		static std::vector<std::string> ParseKeywords(std::string_view keywords);
+
+		// Expects a set as returned by ParseKeywords, equal sets give equal strings
+		static std::string JoinKeywords(std::span<const std::string> keywords);
+
 		constexpr Shader() noexcept = default;
 		virtual ~Shader() noexcept = default;
 		Shader(const Shader&) = delete;
@@ -26,10 +82,29 @@ namespace FoxEngine
 		Shader& operator=(Shader&&) noexcept = delete;
 
 		virtual void Bind() = 0;
+
+		// Resolve once and keep the handle, the typed setters below skip the name lookup and the bind
+		template<class T>
+		Uniform<T> Find(std::string_view name) { return { FindUniform(name) }; }
+
+		// The shader must be bound
+		virtual void Set(Uniform<int> uniform, int v0) = 0; // Sampler units
+		virtual void Set(Uniform<float> uniform, float v0) = 0;
+		virtual void Set(Uniform<glm::vec2> uniform, const glm::vec2& v0) = 0;
+		virtual void Set(Uniform<glm::mat4> uniform, const glm::mat4& v0) = 0;
+
+		// Slow path, looks up the name and binds the shader on every call
 		virtual void Uniform1f(std::string_view name, float v0) = 0;  // Deprecate once uniform buffers work
 		virtual void Uniform2f(std::string_view name, float v0, float v1) = 0; // Deprecate once uniform buffers work
 		virtual void UniformMat4f(std::string_view name, const float* v0) = 0;  // Deprecate once uniform buffers work
 
 		virtual bool CullsBackFaces() const noexcept = 0;
+
+		// Always true for shaders not created async. Throws if compilation failed, binding an unfinished shader
+		// blocks and a failed one draws with the flat error shader
+		virtual bool IsReady() = 0;
+	protected:
+		// Returns -1 if the shader has no active uniform of that name
+		virtual int FindUniform(std::string_view name) = 0;
 	};
 }
\ No newline at end of file
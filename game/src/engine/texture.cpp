@@ -1,6 +1,7 @@
 #include "texture.hpp"
 
-#include "vendor/stb_image.h"
+#include "Image.hpp"
+#include "ogl/StateCacheOGL.hpp"
 
 #include <glad/gl.h>
 
@@ -47,6 +48,10 @@ namespace FoxEngine
 		{
 		case Rgba8:
 			return GL_RGBA8;
+		case Rgba16f:
+			return GL_RGBA16F;
+		case R32f:
+			return GL_R32F;
 		case D24:
 			return GL_DEPTH_COMPONENT24;
 		}
@@ -61,7 +66,10 @@ namespace FoxEngine
 		switch (format)
 		{
 		case Rgba8:
+		case Rgba16f:
 			return GL_RGBA;
+		case R32f:
+			return GL_RED;
 		case D24:
 			return GL_DEPTH_COMPONENT;
 		}
@@ -78,6 +86,9 @@ namespace FoxEngine
 		case Rgba8:
 		case D24:
 			return GL_UNSIGNED_BYTE;
+		case Rgba16f:
+		case R32f:
+			return GL_FLOAT;
 		}
 
 		throw std::runtime_error("Invalid texture format");
@@ -127,7 +138,7 @@ namespace FoxEngine
 		}
 
 		glGenTextures(1, &mHandle);
-		glBindTexture(mTarget, mHandle);
+		Bind();
 
 		switch (dims)
 		{
@@ -152,7 +163,10 @@ namespace FoxEngine
 	TextureOGL33::~TextureOGL33() noexcept
 	{
 		if (mHandle)
+		{
+			StateCacheOGL::Get().ForgetTexture(mHandle);
 			glDeleteTextures(1, &mHandle);
+		}
 	}
 
 	TextureOGL33::TextureOGL33(TextureOGL33&& other) noexcept
@@ -193,8 +207,7 @@ namespace FoxEngine
 
 	void TextureOGL33::Bind(unsigned int unit)
 	{
-		glActiveTexture(GL_TEXTURE0 + unit);
-		glBindTexture(mTarget, mHandle);
+		StateCacheOGL::Get().BindTexture(unit, mTarget, mHandle);
 	}
 
 	Poly<Texture> Texture::Create(const CreateInfo& info)
@@ -204,22 +217,27 @@ namespace FoxEngine
 
 	Poly<Texture> Texture::Create(std::string_view resource)
 	{
-		CreateInfo createInfo;
-		createInfo.debugName = resource;
-
-		unsigned char* pixels = stbi_load(resource.data(), &createInfo.width, &createInfo.height, nullptr, 4);
-		if (!pixels) return {};
+		Image image = Image::FromFile(resource);
+		if (!image) return {};
 
-		Poly<Texture> texture = Create(createInfo);
-
-		UploadInfo uploadInfo;
-		uploadInfo.pixels = pixels;
-		uploadInfo.width = createInfo.width;
-		uploadInfo.height = createInfo.height;
-
-		texture->Upload(uploadInfo);
+		return Create(image, resource);
+	}
 
-		stbi_image_free(pixels);
+	Poly<Texture> Texture::Create(const Image& image, std::string_view debugName)
+	{
+		Poly<Texture> texture = Create(
+			{
+				.width = image.Width(),
+				.height = image.Height(),
+				.debugName = debugName
+			});
+
+		texture->Upload(
+			{
+				.width = image.Width(),
+				.height = image.Height(),
+				.pixels = image.Pixels()
+			});
 
 		return texture;
 	}
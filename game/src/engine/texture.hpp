@@ -6,9 +6,11 @@
 
 namespace FoxEngine
 {
+	class Image;
+
 	enum struct ImageFormat
 	{
-		Rgba8, D24
+		Rgba8, Rgba16f, R32f, D24
 	};
 
 	unsigned int TextureFormatToInternalFormat(ImageFormat format);
@@ -54,6 +56,7 @@ namespace FoxEngine
 
 		static Poly<Texture> Create(const CreateInfo& info);
 		static Poly<Texture> Create(std::string_view resource);
+		static Poly<Texture> Create(const Image& image, std::string_view debugName = {});
 	public:
 		constexpr Texture() noexcept = default;
 		virtual ~Texture() noexcept = default;
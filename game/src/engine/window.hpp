@@ -14,6 +14,7 @@ namespace FoxEngine
 			int width = 1280;
 			int height = 720;
 			const char* title = "FoxEngine";
+			bool visible = true; // Hidden windows still own a working context
 		};
 	public:
 		static void PollEvents();
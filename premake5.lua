@@ -116,8 +116,99 @@ feProject "game"
 			"IOKit.framework",
 			"CoreVideo.framework"
         }
+    filter "configurations:not dist"
+        defines "FE_PROFILE"
     filter "configurations:game_debug"
         optimize "Debug"
+    filter {}
+
+-- Console tools built from parts of the engine, only the gpu cases of bench open a (hidden) window
+function feToolProject(name, engineFiles)
+    project(name)
+    location(name)
+    kind "ConsoleApp"
+
+    files
+    {
+        "%{prj.location}/src/**.cpp",
+        "%{prj.location}/src/**.hpp"
+    }
+
+    for _, file in ipairs(engineFiles) do
+        files("%{wks.location}/game/src/engine/" .. file)
+    end
+
+    includedirs
+    {
+        "%{prj.location}/src",
+        "%{wks.location}/game",
+        "%{wks.location}/game/src",
+        vendor_loc .. "glm",
+        vendor_loc .. "tinyfd",
+        vendor_loc .. "spdlog/include"
+    }
+
+    links "tinyfd"
+
+    filter "system:linux"
+        links { "dl", "pthread", "m" }
+    filter {}
+end
+
+group "tools"
+
+feToolProject("bench",
+{
+    "AabbTree.cpp",
+    "blob.cpp",
+    "Buffer.cpp",
+    "FrustumCulling.cpp",
+    "log.cpp",
+    "mesh.cpp",
+    "RenderQueue.cpp",
+    "shader.cpp",
+    "ShaderPreprocessor.cpp",
+    "TransformBatch.cpp",
+    "window.cpp",
+    "ogl/ProgramCacheOGL.cpp",
+    "ogl/ShaderOGL.cpp",
+    "ogl/StateCacheOGL.cpp"
+})
+    includedirs
+    {
+        vendor_loc .. "glfw/include",
+        vendor_loc .. "glad2/include"
+    }
+
+    defines "GLFW_INCLUDE_NONE"
+    links { "glfw", "glad2" }
+
+    filter "system:windows"
+        links "opengl32"
+    filter "system:linux"
+        links "X11"
+    filter "system:macosx"
+        links
+        {
+            "CoreFoundation.framework",
+            "Cocoa.framework",
+            "IOKit.framework",
+            "CoreVideo.framework"
+        }
+    filter {}
+
+feToolProject("tests",
+{
+    "AabbTree.cpp",
+    "blob.cpp",
+    "CookedMesh.cpp",
+    "FrustumCulling.cpp",
+    "log.cpp",
+    "OcclusionCulling.cpp",
+    "ShaderPreprocessor.cpp",
+    "TransformBatch.cpp"
+})
+
 group "deps"
 
 feProject "glfw"
@@ -0,0 +1,149 @@
+#include "Test.hpp"
+
+#include "engine/CookedMesh.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace FoxEngine;
+
+namespace
+{
+	std::string TempResource(const char* name)
+	{
+		std::string resource = (std::filesystem::temp_directory_path() / name).string();
+		std::filesystem::remove(resource);
+		std::filesystem::remove(CookedMesh::PathFor(resource));
+		return resource;
+	}
+
+	std::vector<Mesh::Vertex> Triangle()
+	{
+		std::vector<Mesh::Vertex> vertices(3);
+		vertices[0].position = { 0.0f, 0.0f, 0.0f };
+		vertices[1].position = { 1.0f, 0.0f, 0.0f };
+		vertices[2].position = { 0.0f, 1.0f, 0.0f };
+		return vertices;
+	}
+
+	// Writes a header followed by payloadSize zero bytes, no matter what the counts claim
+	void WriteRaw(const std::string& resource, const CookedMesh::Header& header, std::size_t payloadSize)
+	{
+		std::ofstream out{ CookedMesh::PathFor(resource), std::ios::out | std::ios::binary | std::ios::trunc };
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		std::vector<char> payload(payloadSize);
+		out.write(payload.data(), payload.size());
+	}
+}
+
+FE_TEST(CookedMeshRoundTrip)
+{
+	std::string resource = TempResource("fe_test_round_trip.obj");
+	std::vector<Mesh::Vertex> vertices = Triangle();
+	std::vector<Mesh::Index> indices = { 0, 1, 2 };
+
+	CookedMesh::Write(resource, vertices, indices);
+	auto view = CookedMesh::Load(resource);
+
+	FE_CHECK(view.has_value());
+	FE_CHECK(view && view->vertices.size() == 3);
+	FE_CHECK(view && view->indices.size() == 3);
+	FE_CHECK(view && view->vertices[1].position.x == 1.0f);
+	FE_CHECK(view && view->indices[2] == 2);
+}
+
+FE_TEST(CookedMeshMissing)
+{
+	FE_CHECK(!CookedMesh::Load(TempResource("fe_test_missing.obj")));
+}
+
+FE_TEST(CookedMeshRejectsTruncated)
+{
+	std::string resource = TempResource("fe_test_truncated.obj");
+
+	CookedMesh::Header header;
+	header.vertexCount = 3;
+	header.indexCount = 3;
+	WriteRaw(resource, header, 3 * sizeof(Mesh::Vertex) + 2 * sizeof(Mesh::Index));
+	FE_CHECK(!CookedMesh::Load(resource));
+
+	WriteRaw(resource, header, 3 * sizeof(Mesh::Vertex) + 4 * sizeof(Mesh::Index));
+	FE_CHECK(!CookedMesh::Load(resource));
+
+	WriteRaw(resource, header, 3 * sizeof(Mesh::Vertex) + 3 * sizeof(Mesh::Index));
+	FE_CHECK(CookedMesh::Load(resource).has_value());
+
+	// Shorter than the header itself
+	{
+		std::ofstream out{ CookedMesh::PathFor(resource), std::ios::out | std::ios::binary | std::ios::trunc };
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header) / 2);
+	}
+
+	FE_CHECK(!CookedMesh::Load(resource));
+}
+
+FE_TEST(CookedMeshRejectsBadHeader)
+{
+	std::string resource = TempResource("fe_test_bad_header.obj");
+
+	CookedMesh::Header header;
+	header.magic = 0;
+	WriteRaw(resource, header, 0);
+	FE_CHECK(!CookedMesh::Load(resource));
+
+	header = {};
+	header.version = CookedMesh::Version + 1;
+	WriteRaw(resource, header, 0);
+	FE_CHECK(!CookedMesh::Load(resource));
+
+	header = {};
+	header.vertexStride = sizeof(Mesh::Vertex) + 4;
+	WriteRaw(resource, header, 0);
+	FE_CHECK(!CookedMesh::Load(resource));
+}
+
+FE_TEST(CookedMeshRejectsWrappingCounts)
+{
+	std::string resource = TempResource("fe_test_wrapping.obj");
+
+	// Both products wrap to exactly the payload size in 64 bits
+	static_assert(sizeof(Mesh::Vertex) == 32 && sizeof(Mesh::Index) == 4);
+
+	CookedMesh::Header header;
+	header.vertexCount = std::uint64_t(1) << 59;
+	header.indexCount = 0;
+	WriteRaw(resource, header, 0);
+	FE_CHECK(!CookedMesh::Load(resource));
+
+	header.vertexCount = 1;
+	header.indexCount = (std::uint64_t(1) << 62) + 1;
+	WriteRaw(resource, header, sizeof(Mesh::Vertex) + sizeof(Mesh::Index));
+	FE_CHECK(!CookedMesh::Load(resource));
+}
+
+FE_TEST(CookedMeshRejectsStaleSource)
+{
+	std::string resource = TempResource("fe_test_stale.obj");
+
+	{
+		std::ofstream source{ resource };
+		source << "v 0 0 0\n";
+	}
+
+	std::vector<Mesh::Vertex> vertices = Triangle();
+	std::vector<Mesh::Index> indices = { 0, 1, 2 };
+
+	CookedMesh::Write(resource, vertices, indices);
+	FE_CHECK(CookedMesh::Load(resource).has_value());
+
+	{
+		std::ofstream source{ resource, std::ios::app };
+		source << "v 1 0 0\n";
+	}
+
+	FE_CHECK(!CookedMesh::Load(resource));
+}
@@ -0,0 +1,240 @@
+#include "Test.hpp"
+
+#include "engine/AabbTree.hpp"
+#include "engine/FrustumCulling.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace FoxEngine;
+
+namespace
+{
+	const Mesh::Bounds UnitBounds{ .min = glm::vec3(-0.5f), .max = glm::vec3(0.5f), .center = glm::vec3(0.0f), .radius = 0.87f };
+
+	Frustum CameraFrustum()
+	{
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 50.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		return Frustum::FromMatrix(projection * view);
+	}
+
+	std::vector<Aabb> RandomBoxes(std::size_t count, std::uint32_t seed)
+	{
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> position{ -40.0f, 40.0f };
+		std::uniform_real_distribution<float> size{ 0.1f, 3.0f };
+
+		std::vector<Aabb> boxes(count);
+		for (Aabb& box : boxes)
+		{
+			glm::vec3 center(position(random), position(random), position(random));
+			glm::vec3 extent(size(random), size(random), size(random));
+			box = { center - extent, center + extent };
+		}
+
+		return boxes;
+	}
+
+	bool Intersects(const Frustum& frustum, const Aabb& box)
+	{
+		glm::vec3 center = (box.min + box.max) * 0.5f;
+		glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+		for (const glm::vec4& plane : frustum.planes)
+			if (glm::dot(glm::vec3(plane), center) + plane.w + glm::dot(glm::abs(glm::vec3(plane)), extent) < 0.0f)
+				return false;
+
+		return true;
+	}
+
+	// Every leaf is either reported or counted as rejected, and the fat boxes contain the real ones
+	void CheckQuery(const AabbTree& tree, const Frustum& frustum, const std::vector<Aabb>& boxes, const std::vector<bool>& alive)
+	{
+		std::set<std::uint32_t> reported;
+		std::size_t rejected = tree.QueryFrustum(frustum, [&](std::uint32_t userData) { reported.insert(userData); });
+
+		FE_CHECK(reported.size() + rejected == tree.ProxyCount());
+
+		for (std::uint32_t i = 0; i < boxes.size(); ++i)
+		{
+			if (alive[i] && Intersects(frustum, boxes[i]))
+				FE_CHECK(reported.contains(i));
+
+			if (!alive[i])
+				FE_CHECK(!reported.contains(i));
+		}
+	}
+}
+
+FE_TEST(FrustumPlanes)
+{
+	Frustum frustum = CameraFrustum();
+
+	auto inside = [&](const glm::vec3& point)
+	{
+		for (const glm::vec4& plane : frustum.planes)
+			if (glm::dot(glm::vec3(plane), point) + plane.w < 0.0f)
+				return false;
+
+		return true;
+	};
+
+	FE_CHECK(inside(glm::vec3(0.0f, 0.0f, -5.0f)));
+	FE_CHECK(!inside(glm::vec3(0.0f, 0.0f, 5.0f)));
+	FE_CHECK(!inside(glm::vec3(0.0f, 0.0f, -60.0f)));
+	FE_CHECK(!inside(glm::vec3(0.0f, 0.0f, -0.05f)));
+	FE_CHECK(!inside(glm::vec3(10.0f, 0.0f, -5.0f)));
+	FE_CHECK(!inside(glm::vec3(0.0f, -10.0f, -5.0f)));
+
+	for (const glm::vec4& plane : frustum.planes)
+		FE_CHECK(std::abs(glm::length(glm::vec3(plane)) - 1.0f) < 1e-4f);
+}
+
+FE_TEST(CullingBatchMatchesReference)
+{
+	Frustum frustum = CameraFrustum();
+	std::mt19937 random{ 7 };
+	std::uniform_real_distribution<float> position{ -30.0f, 30.0f };
+	std::uniform_real_distribution<float> angle{ 0.0f, 6.28f };
+
+	CullingBatch batch;
+	std::vector<Aabb> boxes;
+
+	// Not a multiple of the batch width, the padding lanes must not be reported
+	for (int i = 0; i < 1003; ++i)
+	{
+		glm::mat4 world = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+		world = glm::rotate(world, angle(random), glm::vec3(0.3f, 1.0f, 0.2f));
+		world = glm::scale(world, glm::vec3(2.0f, 0.5f, 1.0f));
+
+		batch.Add(UnitBounds, world);
+		boxes.push_back(Aabb::FromBounds(UnitBounds, world));
+	}
+
+	std::vector<std::uint8_t> visible;
+	std::size_t visibleCount = batch.Cull(frustum, visible);
+
+	FE_CHECK(visible.size() == boxes.size());
+
+	std::size_t expected = 0;
+	bool allMatch = true;
+
+	for (std::size_t i = 0; i < boxes.size(); ++i)
+	{
+		bool reference = Intersects(frustum, boxes[i]);
+		expected += reference;
+		allMatch &= (visible[i] != 0) == reference;
+	}
+
+	FE_CHECK(allMatch);
+	FE_CHECK(visibleCount == expected);
+	FE_CHECK(expected > 0 && expected < boxes.size());
+}
+
+FE_TEST(AabbFromBounds)
+{
+	// A quarter turn around y swaps the x and z extents
+	glm::mat4 world = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f)), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Mesh::Bounds bounds{ .min = glm::vec3(-2.0f, -1.0f, -0.5f), .max = glm::vec3(2.0f, 1.0f, 0.5f) };
+
+	Aabb box = Aabb::FromBounds(bounds, world);
+
+	FE_CHECK(glm::length(box.min - glm::vec3(0.5f, 1.0f, 1.0f)) < 1e-4f);
+	FE_CHECK(glm::length(box.max - glm::vec3(1.5f, 3.0f, 5.0f)) < 1e-4f);
+}
+
+FE_TEST(AabbTreeQueries)
+{
+	Frustum frustum = CameraFrustum();
+	std::vector<Aabb> boxes = RandomBoxes(2000, 42);
+	std::vector<bool> alive(boxes.size(), true);
+	std::vector<int> proxies(boxes.size());
+
+	AabbTree tree;
+	for (std::uint32_t i = 0; i < boxes.size(); ++i)
+		proxies[i] = tree.Insert(boxes[i], i);
+
+	FE_CHECK(tree.ProxyCount() == boxes.size());
+
+	// Balanced, a degenerate tree would be thousands of levels deep
+	FE_CHECK(tree.Height() < 40);
+
+	CheckQuery(tree, frustum, boxes, alive);
+
+	// Removing and moving reshapes the tree, the leaf counts of skipped subtrees have to follow
+	std::vector<Aabb> moved = RandomBoxes(boxes.size(), 99);
+
+	for (std::uint32_t i = 0; i < boxes.size(); ++i)
+	{
+		if (i % 3 == 0)
+		{
+			tree.Remove(proxies[i]);
+			alive[i] = false;
+		}
+		else if (i % 3 == 1)
+		{
+			tree.Move(proxies[i], moved[i]);
+			boxes[i] = moved[i];
+		}
+	}
+
+	FE_CHECK(tree.ProxyCount() == boxes.size() - (boxes.size() + 2) / 3);
+	CheckQuery(tree, frustum, boxes, alive);
+
+	// Overlap against brute force on the real boxes, the tree may add neighbours within its margin
+	Aabb probe{ glm::vec3(-10.0f), glm::vec3(10.0f) };
+	std::set<std::uint32_t> overlapping;
+	tree.QueryOverlap(probe, [&](std::uint32_t userData) { overlapping.insert(userData); });
+
+	bool overlapComplete = true;
+	for (std::uint32_t i = 0; i < boxes.size(); ++i)
+		if (alive[i] && boxes[i].Overlaps(probe))
+			overlapComplete &= overlapping.contains(i);
+
+	FE_CHECK(overlapComplete);
+
+	tree.Clear();
+	FE_CHECK(tree.ProxyCount() == 0);
+	FE_CHECK(tree.QueryFrustum(frustum, [](std::uint32_t) {}) == 0);
+}
+
+FE_TEST(AabbTreeRayCast)
+{
+	AabbTree tree{ 0.0f };
+
+	for (std::uint32_t i = 0; i < 10; ++i)
+	{
+		glm::vec3 center(0.0f, 0.0f, -5.0f - 3.0f * i);
+		tree.Insert({ center - glm::vec3(0.5f), center + glm::vec3(0.5f) }, i);
+	}
+
+	// Closest hit, the callback shrinks the search to each hit
+	std::uint32_t closest = ~0u;
+	float closestDistance = 0.0f;
+
+	tree.RayCast(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 100.0f, [&](std::uint32_t userData, float distance)
+		{
+			closest = userData;
+			closestDistance = distance;
+			return distance;
+		});
+
+	FE_CHECK(closest == 0);
+	FE_CHECK(std::abs(closestDistance - 4.5f) < 1e-4f);
+
+	// Every hit within range
+	int hits = 0;
+	tree.RayCast(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 15.0f, [&](std::uint32_t, float) { ++hits; return 15.0f; });
+	FE_CHECK(hits == 4);
+
+	// Misses everything
+	hits = 0;
+	tree.RayCast(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 100.0f, [&](std::uint32_t, float) { ++hits; return 100.0f; });
+	FE_CHECK(hits == 0);
+}
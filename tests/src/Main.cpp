@@ -0,0 +1,60 @@
+#include "Test.hpp"
+
+#include "engine/log.hpp"
+
+#include <exception>
+#include <string_view>
+
+namespace FoxEngine::Test
+{
+	static int sFailures = 0;
+
+	std::vector<Case>& Registry()
+	{
+		static std::vector<Case> cases;
+		return cases;
+	}
+
+	void Fail(const char* expression, const char* file, int line)
+	{
+		Log::Error("    {}:{}: check failed: {}", file, line, expression);
+		++sFailures;
+	}
+}
+
+// tests [filter], runs every test whose name contains the filter, the exit code is the number of failed tests
+int main(int argc, char* argv[])
+{
+	using namespace FoxEngine;
+
+	std::string_view filter = argc > 1 ? argv[1] : "";
+	int failedTests = 0;
+	int ranTests = 0;
+
+	for (const Test::Case& testCase : Test::Registry())
+	{
+		if (std::string_view(testCase.name).find(filter) == std::string_view::npos)
+			continue;
+
+		int failuresBefore = Test::sFailures;
+
+		try
+		{
+			testCase.function();
+		}
+		catch (const std::exception& e)
+		{
+			Log::Error("    unexpected exception: {}", e.what());
+			++Test::sFailures;
+		}
+
+		bool passed = Test::sFailures == failuresBefore;
+		Log::Info("{} {}", passed ? "[pass]" : "[FAIL]", testCase.name);
+
+		failedTests += passed ? 0 : 1;
+		++ranTests;
+	}
+
+	Log::Info("{} of {} tests passed", ranTests - failedTests, ranTests);
+	return failedTests;
+}
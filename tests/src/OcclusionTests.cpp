@@ -0,0 +1,109 @@
+#include "Test.hpp"
+
+#include "engine/OcclusionCulling.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace FoxEngine;
+
+namespace
+{
+	// Camera at the origin looking down -z
+	glm::mat4 ViewProjection()
+	{
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		return projection * view;
+	}
+
+	// Unit quad in the xy plane, facing +z
+	Mesh::Geometry Quad()
+	{
+		return
+		{
+			.positions = { { -0.5f, -0.5f, 0.0f }, { 0.5f, -0.5f, 0.0f }, { 0.5f, 0.5f, 0.0f }, { -0.5f, 0.5f, 0.0f } },
+			.indices = { 0, 1, 2, 0, 2, 3 }
+		};
+	}
+
+	Aabb Box(const glm::vec3& center, float halfSize)
+	{
+		return { center - glm::vec3(halfSize), center + glm::vec3(halfSize) };
+	}
+
+	// A 4x4 wall 10 units in front of the camera
+	OcclusionBuffer& Wall(OcclusionBuffer& buffer)
+	{
+		glm::mat4 world = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)), glm::vec3(4.0f));
+
+		buffer.Begin(ViewProjection());
+		buffer.RasterizeOccluder(Quad(), world);
+		buffer.BuildHierarchy();
+		return buffer;
+	}
+}
+
+FE_TEST(OcclusionEmptyBufferHidesNothing)
+{
+	OcclusionBuffer buffer;
+	buffer.Begin(ViewProjection());
+	buffer.BuildHierarchy();
+
+	FE_CHECK(buffer.IsVisible(Box({ 0.0f, 0.0f, -50.0f }, 0.5f)));
+	FE_CHECK(buffer.IsVisible(Box({ 0.0f, 0.0f, -99.0f }, 0.5f)));
+}
+
+FE_TEST(OcclusionBoxBehindWallIsHidden)
+{
+	OcclusionBuffer buffer;
+	Wall(buffer);
+
+	FE_CHECK(!buffer.IsVisible(Box({ 0.0f, 0.0f, -20.0f }, 0.5f)));
+	FE_CHECK(!buffer.IsVisible(Box({ 0.5f, -0.5f, -30.0f }, 1.0f)));
+
+	FE_CHECK(buffer.GetStats().occluders == 1);
+	FE_CHECK(buffer.GetStats().triangles == 2);
+	FE_CHECK(buffer.GetStats().occluded == 2);
+}
+
+FE_TEST(OcclusionBoxInFrontOrBesideIsVisible)
+{
+	OcclusionBuffer buffer;
+	Wall(buffer);
+
+	// In front of the wall
+	FE_CHECK(buffer.IsVisible(Box({ 0.0f, 0.0f, -5.0f }, 0.5f)));
+
+	// Behind, but the projection pokes out past the wall's edge
+	FE_CHECK(buffer.IsVisible(Box({ 4.0f, 0.0f, -20.0f }, 0.5f)));
+
+	// Behind, next to the wall
+	FE_CHECK(buffer.IsVisible(Box({ 15.0f, 0.0f, -20.0f }, 0.5f)));
+
+	// Straddling the wall
+	FE_CHECK(buffer.IsVisible(Box({ 0.0f, 0.0f, -10.0f }, 0.5f)));
+}
+
+FE_TEST(OcclusionBoxCrossingNearPlaneIsVisible)
+{
+	OcclusionBuffer buffer;
+	Wall(buffer);
+
+	FE_CHECK(buffer.IsVisible(Box({ 0.0f, 0.0f, 0.0f }, 0.5f)));
+	FE_CHECK(buffer.IsVisible(Box({ 0.0f, 0.0f, 5.0f }, 0.5f)));
+}
+
+FE_TEST(OcclusionOccluderClippedByNearPlaneStillOccludes)
+{
+	// A floor running from behind the camera into the distance, boxes under it are hidden
+	glm::mat4 world = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, -10.0f)), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+	world = glm::scale(world, glm::vec3(100.0f, 40.0f, 1.0f));
+
+	OcclusionBuffer buffer;
+	buffer.Begin(ViewProjection());
+	buffer.RasterizeOccluder(Quad(), world);
+	buffer.BuildHierarchy();
+
+	FE_CHECK(!buffer.IsVisible(Box({ 0.0f, -5.0f, -20.0f }, 0.5f)));
+	FE_CHECK(buffer.IsVisible(Box({ 0.0f, 1.0f, -20.0f }, 0.5f)));
+}
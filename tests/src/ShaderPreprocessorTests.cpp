@@ -0,0 +1,173 @@
+#include "Test.hpp"
+
+#include "engine/ShaderPreprocessor.hpp"
+#include "engine/blob.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+using namespace FoxEngine;
+
+namespace
+{
+	std::filesystem::path TempDirectory()
+	{
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / "fe_test_preprocessor";
+		std::filesystem::create_directories(directory);
+		return directory;
+	}
+
+	std::string WriteChunk(const char* name, std::string_view contents)
+	{
+		std::filesystem::path path = TempDirectory() / name;
+		std::ofstream out{ path, std::ios::out | std::ios::trunc };
+		out << contents;
+		return path.generic_string();
+	}
+
+	std::size_t Count(std::string_view string, std::string_view pattern)
+	{
+		std::size_t count = 0;
+
+		for (std::size_t i = string.find(pattern); i != std::string_view::npos; i = string.find(pattern, i + 1))
+			++count;
+
+		return count;
+	}
+
+	ShaderPreprocessor::Result Run(std::string_view source)
+	{
+		return ShaderPreprocessor::Process((TempDirectory() / "root.glsl").generic_string(), source);
+	}
+}
+
+FE_TEST(PreprocessorPragma)
+{
+	FE_CHECK(Run("void main() {}\n").cullsBackFaces);
+	FE_CHECK(!Run("@pragma backface_nocull;\n").cullsBackFaces);
+	FE_CHECK(!Run("  @pragma backface_nocull // trailing comment\n").cullsBackFaces);
+
+	// Commented out directives are not applied
+	FE_CHECK(Run("/*\n@pragma backface_nocull\n*/\n").cullsBackFaces);
+	FE_CHECK(Run("// @pragma backface_nocull\n").cullsBackFaces);
+}
+
+FE_TEST(PreprocessorIncludeKeepsLines)
+{
+	WriteChunk("chunk_lines.glsl", "float chunkValue;\n");
+
+	auto result = Run("line1\n@include \"chunk_lines.glsl\"\nline3\n");
+
+	FE_CHECK(result.files.size() == 2);
+	FE_CHECK(result.files.size() == 2 && result.files[1].ends_with("chunk_lines.glsl"));
+	FE_CHECK(result.source.find("#line 1 1\nfloat chunkValue;\n#line 3 0\nline3\n") != std::string::npos);
+}
+
+FE_TEST(PreprocessorIncludeOnce)
+{
+	WriteChunk("chunk_once.glsl", "float onceValue;\n");
+
+	auto result = Run("@include \"chunk_once.glsl\"\n@include \"chunk_once.glsl\"\n");
+	FE_CHECK(Count(result.source, "float onceValue;") == 1);
+}
+
+FE_TEST(PreprocessorIncludePerBranch)
+{
+	WriteChunk("chunk_branch.glsl", "float branchValue;\n");
+
+	// The vert and frag halves of one file are compiled separately, each needs its own copy
+	auto result = Run(
+		"#ifdef FE_VERT\n"
+		"@include \"chunk_branch.glsl\"\n"
+		"#elif defined FE_FRAG\n"
+		"@include \"chunk_branch.glsl\"\n"
+		"#else\n"
+		"@include \"chunk_branch.glsl\"\n"
+		"#endif\n");
+
+	FE_CHECK(Count(result.source, "float branchValue;") == 3);
+}
+
+FE_TEST(PreprocessorIncludeAfterConditional)
+{
+	WriteChunk("chunk_after.glsl", "float afterValue;\n");
+
+	// Without an #else the chunk may not have been pasted, so it is pasted again
+	auto withoutElse = Run(
+		"#ifdef A\n"
+		"@include \"chunk_after.glsl\"\n"
+		"#endif\n"
+		"@include \"chunk_after.glsl\"\n");
+
+	FE_CHECK(Count(withoutElse.source, "float afterValue;") == 2);
+
+	// Every branch pasted it, once is enough
+	auto withElse = Run(
+		"#  if A\n"
+		"@include \"chunk_after.glsl\"\n"
+		"# else\n"
+		"@include \"chunk_after.glsl\"\n"
+		"#endif\n"
+		"@include \"chunk_after.glsl\"\n");
+
+	FE_CHECK(Count(withElse.source, "float afterValue;") == 2);
+
+	// Included before the block, no branch pastes it again
+	auto before = Run(
+		"@include \"chunk_after.glsl\"\n"
+		"#ifdef A\n"
+		"@include \"chunk_after.glsl\"\n"
+		"#else\n"
+		"@include \"chunk_after.glsl\"\n"
+		"#endif\n");
+
+	FE_CHECK(Count(before.source, "float afterValue;") == 1);
+}
+
+FE_TEST(PreprocessorIncludeNested)
+{
+	WriteChunk("chunk_inner.glsl", "float innerValue;\n");
+	WriteChunk("chunk_outer.glsl",
+		"#ifdef FE_FRAG\n"
+		"@include \"chunk_inner.glsl\"\n"
+		"#endif\n");
+
+	// A chunk with its own conditionals, included from both branches of the root
+	auto result = Run(
+		"#ifdef FE_VERT\n"
+		"@include \"chunk_outer.glsl\"\n"
+		"#else\n"
+		"@include \"chunk_outer.glsl\"\n"
+		"#endif\n");
+
+	FE_CHECK(Count(result.source, "float innerValue;") == 2);
+}
+
+FE_TEST(PreprocessorIncludeCycle)
+{
+	WriteChunk("chunk_cycle_a.glsl", "float cycleA;\n@include \"chunk_cycle_b.glsl\"\n");
+	WriteChunk("chunk_cycle_b.glsl", "#ifdef X\n@include \"chunk_cycle_a.glsl\"\n#else\n@include \"chunk_cycle_a.glsl\"\n#endif\nfloat cycleB;\n");
+
+	auto result = Run("@include \"chunk_cycle_a.glsl\"\n");
+
+	FE_CHECK(Count(result.source, "float cycleA;") == 1);
+	FE_CHECK(Count(result.source, "float cycleB;") == 1);
+}
+
+FE_TEST(PreprocessorMissingInclude)
+{
+	bool threw = false;
+
+	try
+	{
+		Run("@include \"does_not_exist.glsl\"\n");
+	}
+	catch (const Exception::FileRead&)
+	{
+		threw = true;
+	}
+
+	FE_CHECK(threw);
+}
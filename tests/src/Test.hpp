@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+// Minimal test registry, FE_TEST functions run in registration order and FE_CHECK records failures without stopping the test
+
+namespace FoxEngine::Test
+{
+	struct Case final
+	{
+		const char* name;
+		void (*function)();
+	};
+
+	std::vector<Case>& Registry();
+
+	struct Registrar final
+	{
+		Registrar(const char* name, void (*function)())
+		{
+			Registry().push_back({ name, function });
+		}
+	};
+
+	void Fail(const char* expression, const char* file, int line);
+}
+
+#define FE_TEST(name) \
+	static void name(); \
+	static ::FoxEngine::Test::Registrar name##Registrar{ #name, name }; \
+	static void name()
+
+#define FE_CHECK(expression) \
+	((expression) ? (void)0 : ::FoxEngine::Test::Fail(#expression, __FILE__, __LINE__))
@@ -0,0 +1,60 @@
+#include "Test.hpp"
+
+#include "engine/TransformBatch.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace FoxEngine;
+
+// Every lane, including a partial last group, matches translate * toMat4 * scale
+FE_TEST(TransformBatchMatchesGlm)
+{
+	std::mt19937 random{ 42 };
+	std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+
+	struct Input final
+	{
+		glm::vec3 translation;
+		glm::quat orientation;
+		glm::vec3 scale;
+	};
+
+	std::vector<Input> inputs(TransformBatch::Width * 2 + 3);
+	TransformBatch batch;
+
+	for (Input& input : inputs)
+	{
+		input.translation = glm::vec3(unit(random), unit(random), unit(random)) * 10.0f;
+		input.orientation = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+		input.scale = glm::vec3(1.5f + unit(random), 1.5f + unit(random), 1.5f + unit(random));
+
+		batch.Add(input.translation, input.orientation, input.scale);
+	}
+
+	FE_CHECK(batch.Size() == inputs.size());
+
+	// One past the end stays untouched
+	std::vector<glm::mat4> matrices(inputs.size() + 1, glm::mat4(7.0f));
+	batch.Compose(matrices.data());
+
+	for (std::size_t i = 0; i < inputs.size(); ++i)
+	{
+		glm::mat4 expected = glm::translate(glm::mat4(1.0f), inputs[i].translation);
+		expected *= glm::toMat4(inputs[i].orientation);
+		expected = glm::scale(expected, inputs[i].scale);
+
+		float error = 0.0f;
+		for (int column = 0; column < 4; ++column)
+			for (int row = 0; row < 4; ++row)
+				error = std::max(error, std::abs(matrices[i][column][row] - expected[column][row]));
+
+		FE_CHECK(error < 1e-5f);
+	}
+
+	FE_CHECK(matrices.back()[0][0] == 7.0f && matrices.back()[3][3] == 7.0f);
+}